@@ -0,0 +1,12 @@
+#version 150
+
+// Varyings
+in vec4 v_color;
+
+out vec4 fragColor;
+
+void main()
+{
+  // Cells fade against the black background
+  fragColor = vec4(v_color.rgb * v_color.a, 1.0);
+}
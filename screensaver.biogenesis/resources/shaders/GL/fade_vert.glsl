@@ -0,0 +1,18 @@
+#version 150
+
+// Attributes
+in vec4 a_position;
+in vec4 a_colorFrom;
+in vec4 a_colorTo;
+
+// Uniforms
+uniform float u_interpolation;
+
+// Varyings
+out vec4 v_color;
+
+void main()
+{
+  gl_Position = a_position;
+  v_color = mix(a_colorFrom, a_colorTo, u_interpolation);
+}
@@ -1,11 +0,0 @@
-#version 150
-
-// Varyings
-in vec4 v_color;
-
-out vec4 fragColor;
-
-void main()
-{
-  fragColor = v_color;
-}
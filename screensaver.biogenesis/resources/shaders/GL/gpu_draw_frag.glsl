@@ -0,0 +1,66 @@
+#version 150
+
+// Draws the state textures as cells. Like the vertex colors of the fade
+// shader a cell moves from the color it was last shown in to the one it
+// has now, fading in or out against the black background.
+const int COLOR_TIME = 0;
+const int COLOR_COLONY = 1;
+const int COLOR_NEIGHBORS = 2;
+
+// Varyings
+in vec2 v_cell;
+
+out vec4 fragColor;
+
+// Uniforms
+uniform sampler2D u_current;
+uniform sampler2D u_previous;
+uniform sampler2D u_older;
+uniform sampler2D u_palette;
+uniform vec2 u_size;
+uniform vec2 u_cellSize;
+uniform float u_spacing;
+uniform float u_paletteSize;
+uniform int u_colorType;
+uniform float u_interpolation;
+uniform bool u_fadeIn;
+
+vec3 ColorOf(vec4 cell)
+{
+  if (u_colorType == COLOR_COLONY)
+    return cell.gba;
+  float index = floor(cell.g * 255.0 + 0.5);
+  if (u_colorType == COLOR_TIME)
+    index = index * 256.0 + floor(cell.b * 255.0 + 0.5);
+  return texture(u_palette, vec2((index + 0.5) / u_paletteSize, 0.5)).rgb;
+}
+
+void main()
+{
+  vec2 cell = floor(v_cell);
+  vec2 inside = (v_cell - cell) * u_cellSize;
+  if (inside.x >= u_cellSize.x - u_spacing || inside.y >= u_cellSize.y - u_spacing)
+    discard;
+
+  vec2 position = (cell + 0.5) / u_size;
+  vec4 current = texture(u_current, position);
+  vec4 previous = texture(u_previous, position);
+  // Neighbor coloring shows the generation before the current one, colored
+  // by the neighborhood it had
+  bool shownNow = current.r > 0.5;
+  bool shownBefore = previous.r > 0.5;
+  if (u_colorType == COLOR_NEIGHBORS)
+  {
+    shownNow = shownBefore;
+    shownBefore = texture(u_older, position).r > 0.5;
+  }
+  if (u_fadeIn)
+    shownBefore = false;
+
+  vec3 now = ColorOf(current);
+  vec3 before = ColorOf(previous);
+  vec4 from = shownBefore ? vec4(before, 1.0) : vec4(now, 0.0);
+  vec4 to = shownNow ? vec4(now, 1.0) : vec4(before, 0.0);
+  vec4 color = mix(from, to, u_interpolation);
+  fragColor = vec4(color.rgb * color.a, 1.0);
+}
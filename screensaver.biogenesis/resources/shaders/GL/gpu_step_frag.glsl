@@ -0,0 +1,122 @@
+#version 150
+
+// A cell is stored as state in red and its color in the rest: the lifetime
+// as high and low byte in green and blue, the neighbor mask in green, or the
+// colony color itself.
+const int COLOR_TIME = 0;
+const int COLOR_COLONY = 1;
+const int COLOR_NEIGHBORS = 2;
+
+// Uniforms
+uniform sampler2D u_state;
+uniform vec2 u_size;
+uniform int u_colorType;
+uniform float u_maxColor;
+uniform bool u_torus;
+uniform bool u_ruleset;
+
+out vec4 fragColor;
+
+vec4 CellAt(vec2 cell)
+{
+  if (u_torus)
+    return texture(u_state, (mod(cell + u_size, u_size) + 0.5) / u_size);
+  // Without wrapping, rows run into each other as in the dense grid
+  if (cell.x < 0.0)
+  {
+    cell.x += u_size.x;
+    cell.y -= 1.0;
+  }
+  else if (cell.x >= u_size.x)
+  {
+    cell.x -= u_size.x;
+    cell.y += 1.0;
+  }
+  if (cell.y < 0.0 || cell.y >= u_size.y)
+    return vec4(0.0);
+  return texture(u_state, (cell + 0.5) / u_size);
+}
+
+void main()
+{
+  vec2 cell = floor(gl_FragCoord.xy);
+  vec4 self = texture(u_state, (cell + 0.5) / u_size);
+
+  // Neighbors in the order of the step functions, the mask bits follow it
+  float count = 0.0;
+  float neighbors = 0.0;
+  float bit = 1.0;
+  vec3 found0 = vec3(0.0);
+  vec3 found1 = vec3(0.0);
+  vec3 found2 = vec3(0.0);
+  for (int dy = -1; dy <= 1; dy++)
+  {
+    for (int dx = -1; dx <= 1; dx++)
+    {
+      if (dx == 0 && dy == 0)
+        continue;
+      vec4 neighbor = CellAt(cell + vec2(float(dx), float(dy)));
+      if (neighbor.r > 0.5)
+      {
+        if (count == 0.0)
+          found0 = neighbor.gba;
+        else if (count == 1.0)
+          found1 = neighbor.gba;
+        else if (count == 2.0)
+          found2 = neighbor.gba;
+        count += 1.0;
+        neighbors += bit;
+      }
+      bit *= 2.0;
+    }
+  }
+
+  bool alive = self.r > 0.5;
+  bool survives = count == 2.0 || count == 3.0;
+  bool born = count == 3.0;
+  if (u_ruleset && u_colorType == COLOR_NEIGHBORS)
+    born = born || neighbors == 126.0 || neighbors == 219.0;
+  else if (u_ruleset)
+    born = born || count == 6.0;
+
+  vec4 next = self;
+  if (u_colorType == COLOR_TIME)
+  {
+    float lifetime = floor(self.g * 255.0 + 0.5) * 256.0 + floor(self.b * 255.0 + 0.5);
+    if (!alive)
+    {
+      lifetime = 0.0;
+      next.r = born ? 1.0 : 0.0;
+    }
+    else if (survives)
+      lifetime = min(lifetime + 1.0, u_maxColor - 1.0);
+    else
+      next.r = 0.0;
+    next.g = floor(lifetime / 256.0) / 255.0;
+    next.b = mod(lifetime, 256.0) / 255.0;
+  }
+  else if (u_colorType == COLOR_COLONY)
+  {
+    if (!alive && born)
+    {
+      next.r = 1.0;
+      next.gba = found0 == found2 ? found0 : found1;
+    }
+    else if (alive && !survives)
+      next.r = 0.0;
+  }
+  else
+  {
+    if (!alive && born)
+    {
+      next.r = 1.0;
+      next.g = neighbors / 255.0;
+    }
+    else if (alive)
+    {
+      next.r = survives ? 1.0 : 0.0;
+      next.g = neighbors / 255.0;
+    }
+  }
+  fragColor = next;
+}
@@ -2,13 +2,13 @@
 
 // Attributes
 in vec4 a_position;
-in vec4 a_color;
+in vec2 a_cell;
 
 // Varyings
-out vec4 v_color;
+out vec2 v_cell;
 
 void main()
 {
   gl_Position = a_position;
-  v_color = a_color;
+  v_cell = a_cell;
 }
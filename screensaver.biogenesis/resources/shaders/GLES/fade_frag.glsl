@@ -0,0 +1,12 @@
+#version 100
+
+precision mediump float;
+
+// Varyings
+varying vec4 v_color;
+
+void main()
+{
+  // Cells fade against the black background
+  gl_FragColor = vec4(v_color.rgb * v_color.a, 1.0);
+}
@@ -0,0 +1,20 @@
+#version 100
+
+precision mediump float;
+
+// Attributes
+attribute vec4 a_position;
+attribute vec4 a_colorFrom;
+attribute vec4 a_colorTo;
+
+// Uniforms
+uniform float u_interpolation;
+
+// Varyings
+varying vec4 v_color;
+
+void main()
+{
+  gl_Position = a_position;
+  v_color = mix(a_colorFrom, a_colorTo, u_interpolation);
+}
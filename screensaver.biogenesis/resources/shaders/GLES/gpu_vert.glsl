@@ -1,16 +1,16 @@
 #version 100
 
-precision mediump float;
+precision highp float;
 
 // Attributes
 attribute vec4 a_position;
-attribute vec4 a_color;
+attribute vec2 a_cell;
 
 // Varyings
-varying vec4 v_color;
+varying vec2 v_cell;
 
 void main()
 {
   gl_Position = a_position;
-  v_color = a_color;
+  v_cell = a_cell;
 }
@@ -0,0 +1,311 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "GpuGrid.h"
+
+#include <algorithm>
+#include <kodi/AddonBase.h>
+#include <stddef.h>
+#include <string>
+
+bool CGpuGrid::Start()
+{
+  if (!LoadProgram(m_step, "gpu_step_frag.glsl") || !LoadProgram(m_draw, "gpu_draw_frag.glsl"))
+    return false;
+
+  glGenTextures(STATE_TEXTURES, m_states);
+  glGenTextures(1, &m_palette);
+  for (int i = 0; i <= STATE_TEXTURES; i++)
+  {
+    glBindTexture(GL_TEXTURE_2D, i < STATE_TEXTURES ? m_states[i] : m_palette);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glGenFramebuffers(1, &m_framebuffer);
+  glGenBuffers(1, &m_quadVBO);
+  return true;
+}
+
+void CGpuGrid::Stop()
+{
+  glDeleteBuffers(1, &m_quadVBO);
+  glDeleteFramebuffers(1, &m_framebuffer);
+  glDeleteTextures(1, &m_palette);
+  glDeleteTextures(STATE_TEXTURES, m_states);
+}
+
+bool CGpuGrid::LoadProgram(CProgram& program, const char * fragment)
+{
+  std::string vertShader = kodi::addon::GetAddonPath("resources/shaders/" GL_TYPE_STRING "/gpu_vert.glsl");
+  std::string fragShader = kodi::addon::GetAddonPath(std::string("resources/shaders/" GL_TYPE_STRING "/") + fragment);
+  if (!program.LoadShaderFiles(vertShader, fragShader) || !program.CompileAndLink())
+  {
+    kodi::Log(ADDON_LOG_ERROR, "Failed to create and compile shader %s", fragment);
+    return false;
+  }
+  return true;
+}
+
+void CGpuGrid::CProgram::OnCompiledAndLinked()
+{
+  m_aPosition = glGetAttribLocation(ProgramHandle(), "a_position");
+  m_aCell = glGetAttribLocation(ProgramHandle(), "a_cell");
+}
+
+void CGpuGrid::CStepProgram::OnCompiledAndLinked()
+{
+  CProgram::OnCompiledAndLinked();
+  m_uState = Uniform("u_state");
+  m_uSize = Uniform("u_size");
+  m_uColorType = Uniform("u_colorType");
+  m_uMaxColor = Uniform("u_maxColor");
+  m_uTorus = Uniform("u_torus");
+  m_uRuleset = Uniform("u_ruleset");
+}
+
+void CGpuGrid::CDrawProgram::OnCompiledAndLinked()
+{
+  CProgram::OnCompiledAndLinked();
+  const char * samplers[4] = {"u_current", "u_previous", "u_older", "u_palette"};
+  for (int i = 0; i < 4; i++)
+    m_uSamplers[i] = Uniform(samplers[i]);
+  m_uSize = Uniform("u_size");
+  m_uCellSize = Uniform("u_cellSize");
+  m_uSpacing = Uniform("u_spacing");
+  m_uPaletteSize = Uniform("u_paletteSize");
+  m_uColorType = Uniform("u_colorType");
+  m_uInterpolation = Uniform("u_interpolation");
+  m_uFadeIn = Uniform("u_fadeIn");
+}
+
+bool CGpuGrid::Load(const Grid& grid, int screenWidth, int screenHeight)
+{
+  GLint maxSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  if (grid.width > maxSize || grid.height > maxSize || (int)(sizeof(grid.palette)/sizeof(CRGBA)) > maxSize)
+    return false;
+
+  // The newest generation is the current one, the oldest is never shown
+  // before a step replaces it
+  m_current = 1;
+  m_generations = 0;
+  Encode(grid, grid.prevCells);
+  glBindTexture(GL_TEXTURE_2D, Texture(1));
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, grid.width, grid.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_texels.data());
+  Encode(grid, grid.cells);
+  glBindTexture(GL_TEXTURE_2D, Texture(0));
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, grid.width, grid.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_texels.data());
+  std::fill(m_texels.begin(), m_texels.end(), 0);
+  glBindTexture(GL_TEXTURE_2D, Texture(2));
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, grid.width, grid.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_texels.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // GLES2 need not support rendering into RGBA byte textures, steps would
+  // then leave garbage behind
+  GLint framebuffer;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Texture(2), 0);
+  GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  if (status != GL_FRAMEBUFFER_COMPLETE)
+  {
+    kodi::Log(ADDON_LOG_DEBUG, "GPU cannot render into the grid textures, status 0x%x", status);
+    return false;
+  }
+
+  // Lifetime coloring looks up the lifetime, neighbor coloring the mask
+  m_texels.clear();
+  if (grid.colorType == COLOR_TIME)
+  {
+    for (const CRGBA& color : grid.palette)
+      m_texels.insert(m_texels.end(), {FloatToByte(color.r), FloatToByte(color.g), FloatToByte(color.b), 255});
+  }
+  else
+  {
+    for (u32 color : grid.neighborPalette)
+      m_texels.insert(m_texels.end(), {(unsigned char)(color >> 16), (unsigned char)(color >> 8), (unsigned char)color, 255});
+  }
+  m_paletteSize = (int)m_texels.size()/4;
+  glBindTexture(GL_TEXTURE_2D, m_palette);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_paletteSize, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_texels.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // A quad over the whole target for stepping, and one over the cells on
+  // the screen for drawing, both with cell coordinates
+  GLfloat right = -1.0f + 2.0f*grid.width*grid.cellSizeX/screenWidth;
+  GLfloat top = -1.0f + 2.0f*grid.height*grid.cellSizeY/screenHeight;
+  GLfloat w = (GLfloat)grid.width, h = (GLfloat)grid.height;
+  const QuadVertex quads[8] = {
+    {-1.0f, -1.0f, 0.0f, 0.0f}, {1.0f, -1.0f, w, 0.0f}, {-1.0f, 1.0f, 0.0f, h}, {1.0f, 1.0f, w, h},
+    {-1.0f, -1.0f, 0.0f, 0.0f}, {right, -1.0f, w, 0.0f}, {-1.0f, top, 0.0f, h}, {right, top, w, h},
+  };
+  glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(quads), quads, GL_STATIC_DRAW);
+  return true;
+}
+
+// Red is the state, the rest the color: the lifetime as high and low byte
+// in green and blue, the neighbor mask in green, or the colony color. The
+// mask of a loaded generation is not known, but it is only ever drawn once
+// a step has replaced it.
+void CGpuGrid::Encode(const Grid& grid, const Cell * cells)
+{
+  m_texels.resize(grid.width*grid.height*4);
+  unsigned char * texel = m_texels.data();
+  for (int y = 0; y < grid.height; y++)
+  {
+    for (int x = 0; x < grid.width; x++, texel += 4)
+    {
+      const Cell& cell = cells[y*grid.stride + x];
+      texel[0] = cell.state != DEAD ? 255 : 0;
+      texel[1] = texel[2] = texel[3] = 0;
+      if (grid.colorType == COLOR_TIME)
+      {
+        texel[1] = (unsigned char)(cell.lifetime >> 8);
+        texel[2] = (unsigned char)cell.lifetime;
+      }
+      else if (grid.colorType == COLOR_COLONY)
+      {
+        texel[1] = FloatToByte(cell.color.r);
+        texel[2] = FloatToByte(cell.color.g);
+        texel[3] = FloatToByte(cell.color.b);
+      }
+    }
+  }
+}
+
+void CGpuGrid::Decode(const Grid& grid, Cell * cells, GLuint texture)
+{
+  m_texels.resize(grid.width*grid.height*4);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+  glReadPixels(0, 0, grid.width, grid.height, GL_RGBA, GL_UNSIGNED_BYTE, m_texels.data());
+  const unsigned char * texel = m_texels.data();
+  for (int y = 0; y < grid.height; y++)
+  {
+    for (int x = 0; x < grid.width; x++, texel += 4)
+    {
+      Cell& cell = cells[y*grid.stride + x];
+      cell.state = texel[0] ? ALIVE : DEAD;
+      if (grid.colorType == COLOR_TIME)
+      {
+        cell.lifetime = (short)(texel[1] << 8 | texel[2]);
+        cell.color = grid.palette[cell.lifetime];
+      }
+      else if (grid.colorType == COLOR_COLONY)
+        cell.color = CRGBA((int)texel[1], (int)texel[2], (int)texel[3], 255);
+      else
+        cell.color = grid.neighborColors[texel[1]];
+    }
+  }
+}
+
+int CGpuGrid::Store(Grid& grid)
+{
+  GLint framebuffer;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+  Decode(grid, grid.prevCells, Texture(1));
+  Decode(grid, grid.cells, Texture(0));
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+  int population = 0;
+  for (size_t i = 0; i < m_texels.size(); i += 4)
+    population += m_texels[i] != 0;
+  return population;
+}
+
+void CGpuGrid::DrawQuad(CProgram& program, int first)
+{
+  // The step shader has no use for the cell coordinates, so the compiler
+  // may have dropped them
+  GLint position = program.m_aPosition;
+  GLint cell = program.m_aCell;
+  glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
+  glVertexAttribPointer(position, 2, GL_FLOAT, 0, sizeof(QuadVertex), BUFFER_OFFSET(offsetof(QuadVertex, x)));
+  glEnableVertexAttribArray(position);
+  if (cell >= 0)
+  {
+    glVertexAttribPointer(cell, 2, GL_FLOAT, 0, sizeof(QuadVertex), BUFFER_OFFSET(offsetof(QuadVertex, cellX)));
+    glEnableVertexAttribArray(cell);
+  }
+  glDrawArrays(GL_TRIANGLE_STRIP, first, 4);
+  glDisableVertexAttribArray(position);
+  if (cell >= 0)
+    glDisableVertexAttribArray(cell);
+}
+
+// Renders the newest generation into the oldest texture. Kodi may draw
+// through its own framebuffer with blending and scissoring on, all of
+// which is put back afterwards.
+void CGpuGrid::Step(const Grid& grid)
+{
+  GLint framebuffer, viewport[4];
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  GLboolean blend = glIsEnabled(GL_BLEND);
+  GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+  glDisable(GL_BLEND);
+  glDisable(GL_SCISSOR_TEST);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Texture(2), 0);
+  glViewport(0, 0, grid.width, grid.height);
+
+  m_step.EnableShader();
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, Texture(0));
+  glUniform1i(m_step.m_uState, 0);
+  glUniform2f(m_step.m_uSize, (GLfloat)grid.width, (GLfloat)grid.height);
+  glUniform1i(m_step.m_uColorType, grid.colorType);
+  glUniform1f(m_step.m_uMaxColor, (GLfloat)grid.maxColor);
+  glUniform1i(m_step.m_uTorus, grid.torus);
+  glUniform1i(m_step.m_uRuleset, grid.ruleset != 0);
+  DrawQuad(m_step, 0);
+  m_step.DisableShader();
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  if (blend)
+    glEnable(GL_BLEND);
+  if (scissor)
+    glEnable(GL_SCISSOR_TEST);
+
+  m_current = (m_current + 1) % STATE_TEXTURES;
+  m_generations++;
+}
+
+void CGpuGrid::Draw(const Grid& grid, float interpolation)
+{
+  m_draw.EnableShader();
+  for (int i = 0; i < 4; i++)
+  {
+    glActiveTexture(GL_TEXTURE0 + i);
+    glBindTexture(GL_TEXTURE_2D, i < STATE_TEXTURES ? Texture(i) : m_palette);
+    glUniform1i(m_draw.m_uSamplers[i], i);
+  }
+  glUniform2f(m_draw.m_uSize, (GLfloat)grid.width, (GLfloat)grid.height);
+  glUniform2f(m_draw.m_uCellSize, (GLfloat)grid.cellSizeX, (GLfloat)grid.cellSizeY);
+  glUniform1f(m_draw.m_uSpacing, (GLfloat)grid.spacing);
+  glUniform1f(m_draw.m_uPaletteSize, (GLfloat)m_paletteSize);
+  glUniform1i(m_draw.m_uColorType, grid.colorType);
+  glUniform1f(m_draw.m_uInterpolation, interpolation);
+  // Right after loading nothing was shown yet, so everything fades in
+  glUniform1i(m_draw.m_uFadeIn, m_generations < 2);
+  DrawQuad(m_draw, 4);
+  for (int i = 3; i >= 0; i--)
+  {
+    glActiveTexture(GL_TEXTURE0 + i);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+  m_draw.DisableShader();
+}
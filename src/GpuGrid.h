@@ -0,0 +1,113 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "Grid.h"
+
+#include <kodi/gui/gl/GL.h>
+#include <kodi/gui/gl/Shader.h>
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// Simulates and draws a grid in fragment shaders. Each generation is an
+// RGBA texture with a texel per cell, rendered from the one before it
+// through a framebuffer object, and drawing samples the newest ones, so
+// cells only cross the bus when a grid is loaded or read back. The rules,
+// the neighborhood and the coloring are those of the dense step functions.
+// Three generations are kept rather than two, as the cross-fade of
+// neighbor coloring reaches back two generations.
+//
+class CGpuGrid
+{
+public:
+  // Builds the shaders and buffers, needs the GL context
+  bool Start();
+  void Stop();
+
+  // Takes over both generations of a dense grid drawn on a screen of the
+  // given size, false if it does not fit into a texture or the GPU cannot
+  // render into one
+  bool Load(const Grid& grid, int screenWidth, int screenHeight);
+  // Writes both generations back into a dense grid for checks on the CPU
+  // and returns the population
+  int Store(Grid& grid);
+  void Step(const Grid& grid);
+  void Draw(const Grid& grid, float interpolation);
+
+private:
+  // The locations of attributes and uniforms are looked up once, when a
+  // program is linked, rather than every frame
+  class CProgram : public kodi::gui::gl::CShaderProgram
+  {
+  public:
+    void OnCompiledAndLinked() override;
+    bool OnEnabled() override { return true; }
+
+    GLint m_aPosition = -1;
+    GLint m_aCell = -1;
+
+  protected:
+    GLint Uniform(const char * name) const { return glGetUniformLocation(ProgramHandle(), name); }
+  };
+
+  class CStepProgram : public CProgram
+  {
+  public:
+    void OnCompiledAndLinked() override;
+
+    GLint m_uState = -1;
+    GLint m_uSize = -1;
+    GLint m_uColorType = -1;
+    GLint m_uMaxColor = -1;
+    GLint m_uTorus = -1;
+    GLint m_uRuleset = -1;
+  };
+
+  class CDrawProgram : public CProgram
+  {
+  public:
+    void OnCompiledAndLinked() override;
+
+    // The three generations, newest first, and the palette
+    GLint m_uSamplers[4] = {-1, -1, -1, -1};
+    GLint m_uSize = -1;
+    GLint m_uCellSize = -1;
+    GLint m_uSpacing = -1;
+    GLint m_uPaletteSize = -1;
+    GLint m_uColorType = -1;
+    GLint m_uInterpolation = -1;
+    GLint m_uFadeIn = -1;
+  };
+
+  struct QuadVertex
+  {
+    GLfloat x, y;
+    GLfloat cellX, cellY;
+  };
+
+  static const int STATE_TEXTURES = 3;
+
+  bool LoadProgram(CProgram& program, const char * fragment);
+  void DrawQuad(CProgram& program, int first);
+  void Encode(const Grid& grid, const Cell * cells);
+  void Decode(const Grid& grid, Cell * cells, GLuint texture);
+  GLuint Texture(int age) const { return m_states[(m_current + STATE_TEXTURES - age) % STATE_TEXTURES]; }
+
+  CStepProgram m_step;
+  CDrawProgram m_draw;
+  GLuint m_states[STATE_TEXTURES] = {};
+  GLuint m_palette = 0;
+  GLuint m_framebuffer = 0;
+  GLuint m_quadVBO = 0;
+  int m_current = 0; // m_states index of the newest generation.
+  int m_generations = 0; // Generations stepped since the grid was loaded.
+  int m_paletteSize = 1;
+  std::vector<unsigned char> m_texels;
+};
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "types.h"
+
+struct Cell
+{
+  CRGBA color; // The cell color.
+  short lifetime;
+  char state;
+};
+
+#define DEAD 0
+#define ALIVE 1
+#define COLOR_TIME 0
+#define COLOR_COLONY 1
+#define COLOR_NEIGHBORS 2
+
+struct Grid
+{
+  int minSize;
+  int maxSize;
+  int width;
+  int height;
+  int stride; // Cells from one row to the next, ghost columns included.
+  bool torus; // Opposite edges are neighbors.
+  int spacing;
+  int resetTime; // Generations before the grid is created anew.
+  int stepRate;
+  int cellSizeX;
+  int cellSizeY;
+  int colorType;
+  int ruleset;
+  int frameCounter;
+  int maxColor;
+  int presetChance;
+  int allowedColoring;
+  int cellLineLimit;
+  int population; // Live cells in the current generation.
+  CRGBA palette[800];
+  uint32_t neighborPalette[256]; // RenderColor data by neighbor mask.
+  CRGBA neighborColors[256]; // The same colors as the cells carry them.
+  Cell * cells; // The current generation, read only while stepping.
+  Cell * prevCells; // The previous generation, overwritten by the next step.
+  Cell * fullGrid; // Both generations including their dead border.
+};
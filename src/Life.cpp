@@ -10,16 +10,13 @@
  * Ver 1.0 2007-02-12 by Asteron  http://asteron.projects.googlepages.com/home
  */
 
-#include <kodi/addon-instance/Screensaver.h>
+#include "Life.h"
 
-#include "types.h"
+#include "Symmetry.h"
 #include <memory.h>
 #include <stddef.h>
 #ifdef WIN32
 #include <d3d11.h>
-#else
-#include <kodi/gui/gl/GL.h>
-#include <kodi/gui/gl/Shader.h>
 #endif
 
 struct CUSTOMVERTEX
@@ -28,102 +25,31 @@ struct CUSTOMVERTEX
   CRGBA color; // The vertex colour.
 };
 
-struct Cell
-{
-  CRGBA color; // The cell color.
-  short lifetime;
-  char nextstate, state;
-};
-
-#define DEAD 0
-#define ALIVE 1
-#define COLOR_TIME 0
-#define COLOR_COLONY 1
-#define COLOR_NEIGHBORS 2
-
 #ifdef WIN32
 ID3D11DeviceContext* g_pContext = nullptr;
 ID3D11Buffer*        g_pVBuffer = nullptr;
 ID3D11PixelShader*   g_pPShader = nullptr;
 #endif
 
-struct Grid
-{
-  int minSize;
-  int maxSize;
-  int width;
-  int height;
-  int spacing;
-  int resetTime;
-  int cellSizeX;
-  int cellSizeY;
-  int colorType;
-  int ruleset;
-  int frameCounter;
-  int maxColor;
-  int presetChance;
-  int allowedColoring;
-  int cellLineLimit;
-  CRGBA palette[800];
-  Cell * cells;
-  Cell * fullGrid;
-};
-
-class ATTR_DLL_LOCAL CScreensaverBiogenesis
-  : public kodi::addon::CAddonBase
-  , public kodi::addon::CInstanceScreensaver
-#ifndef WIN32
-  , public kodi::gui::gl::CShaderProgram
-#endif
-{
-public:
-  CScreensaverBiogenesis();
-
-  // kodi::addon::CInstanceScreensaver
-  bool Start() override;
-  void Stop() override;
-  void Render() override;
-
-#ifndef WIN32
-  // kodi::gui::gl::CShaderProgram
-  void OnCompiledAndLinked() override;
-  bool OnEnabled() override { return true; };
-#endif
-
-private:
-  static const int PALETTE_SIZE;
-  static const int MAX_COLOR;
-
-  Grid m_grid;
-  int m_width;
-  int m_height;
-  float m_ratio;
-
-  CRGBA randColor();
-  void SetDefaults();
-  void SeedGrid();
-  void presetPalette();
-  void CreateGrid();
-  void reducePalette();
-  void DrawGrid();
-  void UpdateStates();
-  void StepLifetime();
-  void StepNeighbors();
-  void StepColony();
-  void Step();
-  CRGBA HSVtoRGB( float h, float s, float v );
-  void DrawRectangle(int x, int y, int w, int h, const CRGBA& dwColour);
-#ifdef WIN32
-  void InitDXStuff(void);
-#else
-  GLint m_aPosition = -1;
-  GLint m_aColor = -1;
-  GLuint m_vertexVBO;
-  GLuint m_indexVBO;
-#endif
-};
-
 const int CScreensaverBiogenesis::PALETTE_SIZE = sizeof(Grid::palette)/sizeof(CRGBA);
+// Frames per second the reset time setting was chosen for, when a
+// generation was stepped every frame
+const int CScreensaverBiogenesis::RESET_FRAME_RATE = 60;
+// Population density in permille below which the sparse engine takes over
+// and above which the dense one comes back. The sparse step breaks even
+// with the dense loops at roughly 2.5 percent, the gap avoids flipping back
+// and forth on grids hovering around that.
+const int CScreensaverBiogenesis::SPARSE_ENTER_PERMILLE = 15;
+const int CScreensaverBiogenesis::SPARSE_LEAVE_PERMILLE = 30;
+// Generations a band of rows is advanced by while it sits in the cache, and
+// the cache size the band and its halo are sized for.
+const int CScreensaverBiogenesis::BLOCK_GENERATIONS = 8;
+const int CScreensaverBiogenesis::BLOCK_CACHE_BYTES = 512*1024;
+// Dense generations stepped with both kernels before keeping the faster one
+const int CScreensaverBiogenesis::KERNEL_SAMPLES = 8;
+// Cells of the smallest grids calibrated apart, each bucket after that holds
+// grids of up to four times as many cells
+const int CScreensaverBiogenesis::KERNEL_BUCKET_CELLS = 16384;
 CRGBA COLOR_TIMES[] = {
   CRGBA(30,30,200,255),
   CRGBA(120,10,255,255),
@@ -146,13 +72,14 @@ float frand() { return ((float) rand() / (float) RAND_MAX); }
 //
 CScreensaverBiogenesis::CScreensaverBiogenesis()
 {
+  m_createdTime = std::chrono::steady_clock::now();
   m_grid.cells = nullptr;
+  m_grid.prevCells = nullptr;
   m_grid.fullGrid = nullptr;
   m_width = Width();
   m_height = Height();
   m_ratio = (float)m_width/(float)m_height;
-  SetDefaults();
-  CreateGrid();
+  LoadSettings();
 #ifdef WIN32
   g_pContext = reinterpret_cast<ID3D11DeviceContext*>(Device());
   InitDXStuff();
@@ -166,8 +93,8 @@ CScreensaverBiogenesis::CScreensaverBiogenesis()
 bool CScreensaverBiogenesis::Start()
 {
 #ifndef WIN32
-  std::string fraqShader = kodi::addon::GetAddonPath("resources/shaders/" GL_TYPE_STRING "/frag.glsl");
-  std::string vertShader = kodi::addon::GetAddonPath("resources/shaders/" GL_TYPE_STRING "/vert.glsl");
+  std::string fraqShader = kodi::addon::GetAddonPath("resources/shaders/" GL_TYPE_STRING "/fade_frag.glsl");
+  std::string vertShader = kodi::addon::GetAddonPath("resources/shaders/" GL_TYPE_STRING "/fade_vert.glsl");
   if (!LoadShaderFiles(vertShader, fraqShader) || !CompileAndLink())
   {
     kodi::Log(ADDON_LOG_ERROR, "Failed to create and compile shader");
@@ -175,10 +102,16 @@ bool CScreensaverBiogenesis::Start()
   }
 
   glGenBuffers(1, &m_vertexVBO);
-  glGenBuffers(1, &m_indexVBO);
+  m_vertexCount = 0;
+
+  // Grids fall back to the CPU if the GPU shaders fail
+  m_gpuStarted = std::atomic_load(&m_settings)->gpu && m_gpuGrid.Start();
 #endif
 
-  SeedGrid();
+  // The grid is only built once the screensaver is actually shown
+  CreateGrid();
+  m_lastStep = std::chrono::steady_clock::time_point();
+  m_firstFrameDrawn = false;
 
   return true;
 }
@@ -195,10 +128,28 @@ void CScreensaverBiogenesis::Render()
   glClear(GL_COLOR_BUFFER_BIT);
 #endif
 
-  if (m_grid.frameCounter++ == m_grid.resetTime)
-    CreateGrid();
-  Step();
-  DrawGrid();
+  // The simulation runs at stepRate generations per second, frames in
+  // between only move the cross-fade towards the newest generation.
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  float period = 1.0f / m_grid.stepRate;
+  float elapsed = std::chrono::duration<float>(now - m_lastStep).count();
+  if (elapsed >= period)
+  {
+    m_lastStep = now;
+    elapsed = 0.0f;
+    if (m_grid.frameCounter++ == m_grid.resetTime)
+      CreateGrid();
+    Step();
+    UpdateGeometry();
+  }
+  DrawGrid(elapsed / period);
+
+  if (!m_firstFrameDrawn)
+  {
+    m_firstFrameDrawn = true;
+    float startup = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_createdTime).count();
+    kodi::Log(ADDON_LOG_DEBUG, "First frame drawn %.1f ms after creation", startup);
+  }
 }
 
 // Kodi tells us to stop the screensaver
@@ -206,7 +157,7 @@ void CScreensaverBiogenesis::Render()
 // any resources we have created.
 void CScreensaverBiogenesis::Stop()
 {
-  delete m_grid.fullGrid;
+  std::vector<Cell>().swap(m_cellStorage);
   m_grid.fullGrid = nullptr;
 #ifdef WIN32
   SAFE_RELEASE(g_pPShader);
@@ -214,8 +165,10 @@ void CScreensaverBiogenesis::Stop()
 #else
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glDeleteBuffers(1, &m_vertexVBO);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-  glDeleteBuffers(1, &m_indexVBO);
+  if (m_gpuStarted)
+    m_gpuGrid.Stop();
+  m_gpuStarted = false;
+  m_gpu = false;
 #endif
 }
 
@@ -230,27 +183,77 @@ CRGBA CScreensaverBiogenesis::randColor()
   return HSVtoRGB(h,s,v);
 }
 
-void CScreensaverBiogenesis::SetDefaults()
+// Reads every setting once, later changes arrive through SetSetting
+void CScreensaverBiogenesis::LoadSettings()
 {
-  m_grid.minSize = 50;
-  m_grid.maxSize = 250;
-  m_grid.spacing = 1;
-  m_grid.resetTime = 2000;
-  m_grid.presetChance = 30;
-  m_grid.allowedColoring = 7;
-  m_grid.cellLineLimit = 3;
+  std::shared_ptr<Settings> settings = std::make_shared<Settings>();
+  settings->minSize = kodi::addon::GetSettingInt("minsize", settings->minSize);
+  settings->maxSize = kodi::addon::GetSettingInt("maxsize", settings->maxSize);
+  settings->resetTime = kodi::addon::GetSettingInt("resettime", settings->resetTime);
+  settings->stepRate = kodi::addon::GetSettingInt("steprate", settings->stepRate);
+  settings->presetChance = kodi::addon::GetSettingInt("presetchance", settings->presetChance);
+  settings->cellLineLimit = kodi::addon::GetSettingInt("lineminsize", settings->cellLineLimit);
+  settings->warmStart = kodi::addon::GetSettingInt("warmstart", settings->warmStart);
+  settings->torus = kodi::addon::GetSettingBoolean("torus", settings->torus);
+  settings->gpu = kodi::addon::GetSettingBoolean("gpu", settings->gpu);
+  settings->colony = kodi::addon::GetSettingBoolean("colony", settings->colony);
+  settings->lifetime = kodi::addon::GetSettingBoolean("lifetime", settings->lifetime);
+  settings->neighbour = kodi::addon::GetSettingBoolean("neighbour", settings->neighbour);
+  std::atomic_store(&m_settings, std::shared_ptr<const Settings>(settings));
+}
+
+// Kodi may call this from another thread, so the snapshot is never changed
+// in place but replaced by an updated copy. It applies from the next reset.
+ADDON_STATUS CScreensaverBiogenesis::SetSetting(const std::string& settingName,
+                                                const kodi::addon::CSettingValue& settingValue)
+{
+  std::shared_ptr<Settings> settings = std::make_shared<Settings>(*std::atomic_load(&m_settings));
+  if (settingName == "minsize")
+    settings->minSize = settingValue.GetInt();
+  else if (settingName == "maxsize")
+    settings->maxSize = settingValue.GetInt();
+  else if (settingName == "resettime")
+    settings->resetTime = settingValue.GetInt();
+  else if (settingName == "steprate")
+    settings->stepRate = settingValue.GetInt();
+  else if (settingName == "presetchance")
+    settings->presetChance = settingValue.GetInt();
+  else if (settingName == "lineminsize")
+    settings->cellLineLimit = settingValue.GetInt();
+  else if (settingName == "warmstart")
+    settings->warmStart = settingValue.GetInt();
+  else if (settingName == "torus")
+    settings->torus = settingValue.GetBoolean();
+  else if (settingName == "gpu")
+    settings->gpu = settingValue.GetBoolean();
+  else if (settingName == "colony")
+    settings->colony = settingValue.GetBoolean();
+  else if (settingName == "lifetime")
+    settings->lifetime = settingValue.GetBoolean();
+  else if (settingName == "neighbour")
+    settings->neighbour = settingValue.GetBoolean();
+  else
+    return ADDON_STATUS_UNKNOWN;
+  std::atomic_store(&m_settings, std::shared_ptr<const Settings>(settings));
+  return ADDON_STATUS_OK;
 }
 
 void CScreensaverBiogenesis::SeedGrid()
 {
-  memset(m_grid.cells,0, m_grid.width*m_grid.height*sizeof(Cell));
-  for ( int i = 0; i<m_grid.width*m_grid.height; i++ )
+  m_sparse = false;
+  m_sparseGrid.Clear();
+  m_planeCurrent = false;
+  m_gpu = false;
+  m_grid.population = 0;
+  memset(m_grid.fullGrid,0, 2*GenerationSize()*sizeof(Cell));
+  for ( int y = 0; y<m_grid.height; y++ )
+  for ( int i = y*m_grid.stride; i<y*m_grid.stride+m_grid.width; i++ )
   {
     m_grid.cells[i].lifetime = 0;
     if (rand() % 4 == 0)
     {
       m_grid.cells[i].state = ALIVE;
-      m_grid.cells[i].nextstate = m_grid.cells[i].state;
+      m_grid.population++;
       if (m_grid.colorType == COLOR_TIME)
         m_grid.cells[i].color = m_grid.palette[m_grid.cells[i].lifetime];
       else
@@ -259,6 +262,8 @@ void CScreensaverBiogenesis::SeedGrid()
       }
     }
   }
+  if (m_grid.torus)
+    RefreshGhosts(m_grid.cells);
 }
 
 void CScreensaverBiogenesis::presetPalette()
@@ -281,24 +286,57 @@ void CScreensaverBiogenesis::presetPalette()
 void CScreensaverBiogenesis::CreateGrid()
 {
   int i, cellmin, cellmax;
-
-  m_grid.minSize = kodi::addon::GetSettingInt("minsize");
-  m_grid.maxSize = kodi::addon::GetSettingInt("maxsize");
-  m_grid.resetTime = kodi::addon::GetSettingInt("resettime");
-  m_grid.presetChance = kodi::addon::GetSettingInt("presetchance");
-  m_grid.cellLineLimit = kodi::addon::GetSettingInt("lineminsize");
-
-  if (!kodi::addon::GetSettingBoolean("colony"))
-    m_grid.allowedColoring ^= (1 << COLOR_COLONY);
-  if (!kodi::addon::GetSettingBoolean("lifetime"))
-    m_grid.allowedColoring ^= (1 << COLOR_TIME);
-  if (!kodi::addon::GetSettingBoolean("neighbour"))
-    m_grid.allowedColoring ^= (1 << COLOR_NEIGHBORS);
-
-  cellmin = (int)sqrt((float)(m_width*m_height/(int)(m_grid.maxSize*m_grid.maxSize*m_ratio)));
-  cellmax = (int)sqrt((float)(m_width*m_height/(int)(m_grid.minSize*m_grid.minSize*m_ratio)));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  std::shared_ptr<const Settings> settings = std::atomic_load(&m_settings);
+  m_grid.minSize = settings->minSize;
+  m_grid.maxSize = settings->maxSize;
+  m_grid.stepRate = settings->stepRate;
+  // The reset time counts frames at the rate the grid used to be stepped
+  // at, which is kept as the time a grid lasts
+  m_grid.resetTime = settings->resetTime * m_grid.stepRate / RESET_FRAME_RATE;
+  if (m_grid.resetTime < 1)
+    m_grid.resetTime = 1;
+  m_grid.presetChance = settings->presetChance;
+  m_grid.cellLineLimit = settings->cellLineLimit;
+
+  m_grid.allowedColoring = 0;
+  if (settings->colony)
+    m_grid.allowedColoring |= (1 << COLOR_COLONY);
+  if (settings->lifetime)
+    m_grid.allowedColoring |= (1 << COLOR_TIME);
+  if (settings->neighbour)
+    m_grid.allowedColoring |= (1 << COLOR_NEIGHBORS);
+
+  // Small sizes on a portrait screen can round the grid area down to 0
+  int maxArea = (int)(m_grid.maxSize*m_grid.maxSize*m_ratio);
+  int minArea = (int)(m_grid.minSize*m_grid.minSize*m_ratio);
+  if (maxArea < 1)
+    maxArea = 1;
+  if (minArea < 1)
+    minArea = 1;
+  cellmin = (int)sqrt((float)(m_width*m_height/maxArea));
+  cellmax = (int)sqrt((float)(m_width*m_height/minArea));
+  // Nothing keeps minsize below maxsize in the settings
+  if (cellmin > cellmax)
+  {
+    int larger = cellmin;
+    cellmin = cellmax;
+    cellmax = larger;
+  }
   m_grid.cellSizeX = rand()%(cellmax - cellmin + 1) + cellmin;
   m_grid.cellSizeY = m_grid.cellSizeX > 5 ? (int)(m_ratio * m_grid.cellSizeX) : m_grid.cellSizeX;
+  // Large sizes round cells down to nothing and the smallest ones can ask
+  // for cells larger than the screen, keep them between a pixel and one
+  // row or column
+  if (m_grid.cellSizeX < 1)
+    m_grid.cellSizeX = 1;
+  if (m_grid.cellSizeX > m_width)
+    m_grid.cellSizeX = m_width;
+  if (m_grid.cellSizeY < 1)
+    m_grid.cellSizeY = 1;
+  if (m_grid.cellSizeY > m_height)
+    m_grid.cellSizeY = m_height;
   m_grid.width = m_width/m_grid.cellSizeX;
   m_grid.height = m_height/m_grid.cellSizeY;
 
@@ -307,11 +345,33 @@ void CScreensaverBiogenesis::CreateGrid()
   else m_grid.spacing = 1;
 
 
-  if (m_grid.fullGrid)
-    delete m_grid.fullGrid;
-  m_grid.fullGrid = new Cell[m_grid.width*(m_grid.height+2)+2];
-  memset(m_grid.fullGrid,0, (m_grid.width*(m_grid.height+2)+2) * sizeof(Cell));
-  m_grid.cells = &m_grid.fullGrid[m_grid.width + 1];
+  if (m_ghostGenerations && m_grid.torus)
+    kodi::Log(ADDON_LOG_DEBUG, "Ghost cell refresh took %.1f us per generation",
+              m_ghostSeconds * 1e6f / m_ghostGenerations);
+  m_ghostSeconds = 0.0f;
+  m_ghostGenerations = 0;
+
+  // Two generations, each padded with a dead row above and below. On a
+  // torus every row also gets a ghost column at either end, and the ghost
+  // cells mirror the opposite edge.
+  m_grid.torus = settings->torus;
+  m_grid.stride = m_grid.torus ? m_grid.width + 2 : m_grid.width;
+  // The buffer only grows, so over many resets it settles at the largest
+  // grid instead of being allocated anew each time
+  int generationSize = GenerationSize();
+  if ((int)m_cellStorage.size() < 2*generationSize)
+  {
+    m_cellStorage.clear();
+    m_cellStorage.resize(2*generationSize);
+  }
+  m_grid.fullGrid = m_cellStorage.data();
+  memset(m_grid.fullGrid,0, 2*generationSize * sizeof(Cell));
+  m_grid.cells = &m_grid.fullGrid[m_grid.stride + 1];
+  m_grid.prevCells = &m_grid.fullGrid[generationSize + m_grid.stride + 1];
+  m_shownColors.assign(m_grid.width*m_grid.height, CRGBA(0, 0, 0, 0));
+  m_shownStamps.assign(m_grid.width*m_grid.height, 0);
+  m_shownList.clear();
+  m_uploadCount = 0;
   m_grid.frameCounter = 0;
   do
   {
@@ -341,206 +401,649 @@ void CScreensaverBiogenesis::CreateGrid()
     reducePalette();
   }
   SeedGrid();
+  // Skip the noisy first generations of the random soup if asked to
+  FastForward(settings->warmStart);
+#ifndef WIN32
+  // The grid is seeded on the CPU either way, then handed over once
+  if (m_gpuStarted && settings->gpu)
+  {
+    m_gpu = m_gpuGrid.Load(m_grid, m_width, m_height);
+    if (!m_gpu)
+      kodi::Log(ADDON_LOG_DEBUG, "Grid of %dx%d cells stays on the CPU", m_grid.width, m_grid.height);
+  }
+#endif
+  kodi::Log(ADDON_LOG_DEBUG, "Grid of %dx%d cells created in %.1f ms", m_grid.width, m_grid.height,
+            std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
 }
 
-int * rotateBits(int * bits)
-{
-  int temp;
-  temp = bits[0];
-  bits[0] = bits[2];
-  bits[2] = bits[7];
-  bits[7] = bits[5];
-  bits[5] = temp;
-  temp = bits[1];
-  bits[1] = bits[4];
-  bits[4] = bits[6];
-  bits[6] = bits[3];
-  bits[3] = temp;
-  return bits;
-}
-int * flipBits(int * bits)
-{
-  int temp;
-  temp = bits[0];
-  bits[0] = bits[2];
-  bits[2] = temp;
-  temp = bits[3];
-  bits[3] = bits[4];
-  bits[4] = temp;
-  temp = bits[5];
-  bits[5] = bits[7];
-  bits[7] = temp;
-  return bits;
-}
-int packBits(int * bits)
+// This simplifies the neighbor palette based off of symmetry
+void CScreensaverBiogenesis::reducePalette()
 {
-  int packed = 0;
-  for(int j = 0; j<8; j++)
-    packed |= bits[j] << j;
-  return packed;
+  for (int i = 0; i < 256; i++)
+  {
+    m_grid.neighborColors[i] = m_grid.palette[NEIGHBOR_SYMMETRY.canonical[i]];
+    m_grid.neighborPalette[i] = m_grid.neighborColors[i].RenderColor();
+  }
 }
-void unpackBits(int num, int * bits)
+
+// Rebuilds the cell quads once per generation. Each vertex carries the color
+// the cell had in the previously shown generation and the one it has now,
+// a dead cell keeping its last color with zero alpha so it fades out in it.
+void CScreensaverBiogenesis::UpdateGeometry()
 {
-  for(int i=0; i<8; i++)
-    bits[i] = (num & (1<<i))>>i ;
+#ifndef WIN32
+  if (m_gpu)
+    return;
+
+  m_vertices.clear();
+  m_nextShownList.clear();
+  m_uploadCount++;
+  ForEachShownCell([this](int i, CRGBA to) {
+    CRGBA from = m_shownColors[i];
+    to.a = 1.0f;
+    if (from.a == 0.0f)
+      from.Set(to.r, to.g, to.b, 0.0f);
+    m_shownColors[i] = to;
+    m_shownStamps[i] = m_uploadCount;
+    m_nextShownList.push_back(i);
+    AddQuad(i, from, to);
+  });
+  for (int i : m_shownList)
+  {
+    if (m_shownStamps[i] == m_uploadCount)
+      continue;
+    CRGBA from = m_shownColors[i];
+    m_shownColors[i].a = 0.0f;
+    AddQuad(i, from, m_shownColors[i]);
+  }
+  m_shownList.swap(m_nextShownList);
+
+  m_vertexCount = m_vertices.size();
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex)*m_vertices.size(), m_vertices.data(), GL_DYNAMIC_DRAW);
+#endif
 }
-// This simplifies the neighbor palette based off of symmetry
-void CScreensaverBiogenesis::reducePalette()
+
+#ifndef WIN32
+void CScreensaverBiogenesis::AddQuad(int i, const CRGBA& from, const CRGBA& to)
 {
-  int i = 0, bits[8], inf, temp;
-  for(i = 0; i < 256; i++)
+  int x = (i%m_grid.width)*m_grid.cellSizeX;
+  int y = (i/m_grid.width)*m_grid.cellSizeY;
+  GLfloat x1 = -1.0 + 2.0*x/m_width;
+  GLfloat y1 = -1.0 + 2.0*y/m_height;
+  GLfloat x2 = -1.0 + 2.0*(x+m_grid.cellSizeX-m_grid.spacing)/m_width;
+  GLfloat y2 = -1.0 + 2.0*(y+m_grid.cellSizeY-m_grid.spacing)/m_height;
+  PackedVertex vertex = {x1, y1, {from.r, from.g, from.b, from.a}, {to.r, to.g, to.b, to.a}};
+  const GLfloat corners[6][2] = {{x1, y1}, {x2, y1}, {x2, y2}, {x2, y2}, {x1, y2}, {x1, y1}};
+  for (int j = 0; j < 6; j++)
   {
-    inf = i;
-    unpackBits(i, bits);
-    for(int k = 0; k < 2; k++)
-    {
-      for(int j = 0; j<4; j++)
-        if ((temp = packBits(rotateBits(bits))) < inf)
-          inf = temp;
-      flipBits(bits);
-    }
-    m_grid.palette[i] = m_grid.palette[inf];
+    vertex.x = corners[j][0];
+    vertex.y = corners[j][1];
+    m_vertices.push_back(vertex);
   }
 }
+#endif
 
-void CScreensaverBiogenesis::DrawGrid()
+void CScreensaverBiogenesis::DrawGrid(float interpolation)
 {
 #ifdef WIN32
   g_pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
   UINT strides = sizeof(CUSTOMVERTEX), offsets = 0;
   g_pContext->IASetVertexBuffers(0, 1, &g_pVBuffer, &strides, &offsets);
   g_pContext->PSSetShader(g_pPShader, NULL, 0);
+  ForEachShownCell([this](int i, const CRGBA& color) {
+    DrawRectangle((i%m_grid.width)*m_grid.cellSizeX,(i/m_grid.width)*m_grid.cellSizeY,
+      m_grid.cellSizeX - m_grid.spacing, m_grid.cellSizeY - m_grid.spacing, color);
+  });
+#else
+  if (m_gpu)
+  {
+    m_gpuGrid.Draw(m_grid, interpolation);
+    return;
+  }
+  if (m_vertexCount == 0)
+    return;
+
+  m_interpolation = interpolation;
+  EnableShader();
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
+  glVertexAttribPointer(m_aPosition, 2, GL_FLOAT, 0, sizeof(PackedVertex), BUFFER_OFFSET(offsetof(PackedVertex, x)));
+  glVertexAttribPointer(m_aColorFrom, 4, GL_FLOAT, 0, sizeof(PackedVertex), BUFFER_OFFSET(offsetof(PackedVertex, from)));
+  glVertexAttribPointer(m_aColorTo, 4, GL_FLOAT, 0, sizeof(PackedVertex), BUFFER_OFFSET(offsetof(PackedVertex, to)));
+
+  glEnableVertexAttribArray(m_aPosition);
+  glEnableVertexAttribArray(m_aColorFrom);
+  glEnableVertexAttribArray(m_aColorTo);
+
+  glDrawArrays(GL_TRIANGLES, 0, m_vertexCount);
+
+  glDisableVertexAttribArray(m_aPosition);
+  glDisableVertexAttribArray(m_aColorFrom);
+  glDisableVertexAttribArray(m_aColorTo);
+
+  DisableShader();
 #endif
-  for(int i = 0; i<m_grid.width*m_grid.height; i++ )
-    if (m_grid.cells[i].state != DEAD)
-      DrawRectangle((i%m_grid.width)*m_grid.cellSizeX,(i/m_grid.width)*m_grid.cellSizeY,
-        m_grid.cellSizeX - m_grid.spacing, m_grid.cellSizeY - m_grid.spacing, m_grid.cells[i].color);
 }
 
-void CScreensaverBiogenesis::UpdateStates()
+// The step functions read m_grid.cells and write every cell of
+// m_grid.prevCells, afterwards the written buffer becomes current.
+void CScreensaverBiogenesis::SwapGenerations()
 {
-  for(int i = 0; i<m_grid.width*m_grid.height; i++ )
-    m_grid.cells[i].state = m_grid.cells[i].nextstate;
+  Cell * temp = m_grid.cells;
+  m_grid.cells = m_grid.prevCells;
+  m_grid.prevCells = temp;
 }
 
-void CScreensaverBiogenesis::StepLifetime()
+int CScreensaverBiogenesis::StepLifetime(const Cell * cur, Cell * next, int begin, int end)
 {
+  int population = 0;
   int i;
-  for(i = 0; i<m_grid.width*m_grid.height; i++ )
+  for(i = begin; i<end; i++ )
   {
     int count = 0;
-    if(m_grid.cells[i-m_grid.width-1].state) count++;
-    if(m_grid.cells[i-m_grid.width  ].state) count++;
-    if(m_grid.cells[i-m_grid.width+1].state) count++;
-    if(m_grid.cells[i           -1].state) count++;
-    if(m_grid.cells[i           +1].state) count++;
-    if(m_grid.cells[i+m_grid.width-1].state) count++;
-    if(m_grid.cells[i+m_grid.width  ].state) count++;
-    if(m_grid.cells[i+m_grid.width+1].state) count++;
-
-    if(m_grid.cells[i].state == DEAD)
+    if(cur[i-m_grid.stride-1].state) count++;
+    if(cur[i-m_grid.stride  ].state) count++;
+    if(cur[i-m_grid.stride+1].state) count++;
+    if(cur[i           -1].state) count++;
+    if(cur[i           +1].state) count++;
+    if(cur[i+m_grid.stride-1].state) count++;
+    if(cur[i+m_grid.stride  ].state) count++;
+    if(cur[i+m_grid.stride+1].state) count++;
+
+    next[i] = cur[i];
+    if(cur[i].state == DEAD)
     {
-      m_grid.cells[i].lifetime = 0;
+      next[i].lifetime = 0;
       if (count == 3 || (m_grid.ruleset && count == 6))
       {
-        m_grid.cells[i].nextstate = ALIVE;
-        m_grid.cells[i].color = m_grid.palette[0];
+        next[i].state = ALIVE;
+        next[i].color = m_grid.palette[0];
       }
     }
     else
     {
       if (count == 2 || count == 3)
       {
-        m_grid.cells[i].lifetime++;
-        if (m_grid.cells[i].lifetime >= m_grid.maxColor)
-          m_grid.cells[i].lifetime = m_grid.maxColor - 1;
-        m_grid.cells[i].color = m_grid.palette[m_grid.cells[i].lifetime];
+        next[i].lifetime++;
+        if (next[i].lifetime >= m_grid.maxColor)
+          next[i].lifetime = m_grid.maxColor - 1;
+        next[i].color = m_grid.palette[next[i].lifetime];
       }
       else
-        m_grid.cells[i].nextstate = DEAD;
+        next[i].state = DEAD;
     }
+    population += next[i].state;
   }
-  UpdateStates();
+  return population;
 }
 
-void CScreensaverBiogenesis::StepNeighbors()
+int CScreensaverBiogenesis::StepNeighbors(const Cell * cur, Cell * next, int begin, int end)
 {
-  UpdateStates();
+  int population = 0;
   int i;
-  for(i = 0; i<m_grid.width*m_grid.height; i++ )
+  for(i = begin; i<end; i++ )
   {
     int count = 0;
     int neighbors = 0;
-    if(m_grid.cells[i-m_grid.width-1].state) {count++; neighbors |=  1;}
-    if(m_grid.cells[i-m_grid.width  ].state) {count++; neighbors |=  2;}
-    if(m_grid.cells[i-m_grid.width+1].state) {count++; neighbors |=  4;}
-    if(m_grid.cells[i           -1].state) {count++; neighbors |=  8;}
-    if(m_grid.cells[i           +1].state) {count++; neighbors |= 16;}
-    if(m_grid.cells[i+m_grid.width-1].state) {count++; neighbors |= 32;}
-    if(m_grid.cells[i+m_grid.width  ].state) {count++; neighbors |= 64;}
-    if(m_grid.cells[i+m_grid.width+1].state) {count++; neighbors |=128;}
-
-    if(m_grid.cells[i].state == DEAD)
+    if(cur[i-m_grid.stride-1].state) {count++; neighbors |=  1;}
+    if(cur[i-m_grid.stride  ].state) {count++; neighbors |=  2;}
+    if(cur[i-m_grid.stride+1].state) {count++; neighbors |=  4;}
+    if(cur[i           -1].state) {count++; neighbors |=  8;}
+    if(cur[i           +1].state) {count++; neighbors |= 16;}
+    if(cur[i+m_grid.stride-1].state) {count++; neighbors |= 32;}
+    if(cur[i+m_grid.stride  ].state) {count++; neighbors |= 64;}
+    if(cur[i+m_grid.stride+1].state) {count++; neighbors |=128;}
+
+    // The color is that of the current generation, DrawGrid pairs it with
+    // the states of this generation once the buffers are swapped.
+    next[i] = cur[i];
+    if(cur[i].state == DEAD)
     {
       if (count == 3 || (m_grid.ruleset && (neighbors == 0x7E || neighbors == 0xDB)))
       {
-        m_grid.cells[i].nextstate = ALIVE;
-        m_grid.cells[i].color = m_grid.palette[neighbors];
+        next[i].state = ALIVE;
+        next[i].color = m_grid.neighborColors[neighbors];
       }
     }
     else
     {
       if (count != 2 && count != 3)
-        m_grid.cells[i].nextstate = DEAD;
-      m_grid.cells[i].color = m_grid.palette[neighbors];
+        next[i].state = DEAD;
+      next[i].color = m_grid.neighborColors[neighbors];
     }
+    population += next[i].state;
   }
+  return population;
 }
 
-void CScreensaverBiogenesis::StepColony()
+int CScreensaverBiogenesis::StepColony(const Cell * cur, Cell * next, int begin, int end)
 {
   CRGBA foundColors[8];
+  int population = 0;
   int i;
-  for(i = 0; i<m_grid.width*m_grid.height; i++ )
+  for(i = begin; i<end; i++ )
   {
     int count = 0;
-    if(m_grid.cells[i-m_grid.width-1].state) foundColors[count++] = m_grid.cells[i-m_grid.width-1].color;
-    if(m_grid.cells[i-m_grid.width  ].state) foundColors[count++] = m_grid.cells[i-m_grid.width  ].color;
-    if(m_grid.cells[i-m_grid.width+1].state) foundColors[count++] = m_grid.cells[i-m_grid.width+1].color;
-    if(m_grid.cells[i           -1].state) foundColors[count++] = m_grid.cells[i           -1].color;
-    if(m_grid.cells[i           +1].state) foundColors[count++] = m_grid.cells[i           +1].color;
-    if(m_grid.cells[i+m_grid.width-1].state) foundColors[count++] = m_grid.cells[i+m_grid.width-1].color;
-    if(m_grid.cells[i+m_grid.width  ].state) foundColors[count++] = m_grid.cells[i+m_grid.width  ].color;
-    if(m_grid.cells[i+m_grid.width+1].state) foundColors[count++] = m_grid.cells[i+m_grid.width+1].color;
-
-    if(m_grid.cells[i].state == DEAD)
+    if(cur[i-m_grid.stride-1].state) foundColors[count++] = cur[i-m_grid.stride-1].color;
+    if(cur[i-m_grid.stride  ].state) foundColors[count++] = cur[i-m_grid.stride  ].color;
+    if(cur[i-m_grid.stride+1].state) foundColors[count++] = cur[i-m_grid.stride+1].color;
+    if(cur[i           -1].state) foundColors[count++] = cur[i           -1].color;
+    if(cur[i           +1].state) foundColors[count++] = cur[i           +1].color;
+    if(cur[i+m_grid.stride-1].state) foundColors[count++] = cur[i+m_grid.stride-1].color;
+    if(cur[i+m_grid.stride  ].state) foundColors[count++] = cur[i+m_grid.stride  ].color;
+    if(cur[i+m_grid.stride+1].state) foundColors[count++] = cur[i+m_grid.stride+1].color;
+
+    next[i] = cur[i];
+    if(cur[i].state == DEAD)
     {
       if (count == 3 || (m_grid.ruleset && count == 6))
       {
         if (foundColors[0] == foundColors[2])
-          m_grid.cells[i].color = foundColors[0];
+          next[i].color = foundColors[0];
         else
-          m_grid.cells[i].color = foundColors[1];
-        m_grid.cells[i].nextstate = ALIVE;
+          next[i].color = foundColors[1];
+        next[i].state = ALIVE;
       }
     }
     else if (count != 2 && count != 3)
-      m_grid.cells[i].nextstate = DEAD;
-
+      next[i].state = DEAD;
+    population += next[i].state;
   }
-  UpdateStates();
+  return population;
 }
 
 void CScreensaverBiogenesis::Step()
+{
+#ifndef WIN32
+  if (m_gpu)
+  {
+    m_gpuGrid.Step(m_grid);
+    return;
+  }
+#endif
+  if (m_sparse)
+  {
+    m_sparseGrid.Step(m_grid);
+    m_grid.population = m_sparseGrid.Population();
+  }
+  else
+    StepDense();
+  SelectEngine();
+}
+
+// Steps the dense grid with the kernel chosen for this CPU
+void CScreensaverBiogenesis::StepDense()
+{
+  Kernel kernel = CurrentKernel().kernel;
+  if (kernel == KERNEL_TABLE)
+    m_grid.population = StepTable(m_grid.cells, m_grid.prevCells);
+  else if (kernel == KERNEL_SCALAR)
+  {
+    m_grid.population = StepScalar(m_grid.cells, m_grid.prevCells);
+    m_planeCurrent = false;
+  }
+  else
+    m_grid.population = CalibrateKernels(m_grid.cells, m_grid.prevCells);
+  if (m_grid.torus)
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    RefreshGhosts(m_grid.prevCells);
+    m_ghostSeconds += std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    m_ghostGenerations++;
+  }
+  SwapGenerations();
+}
+
+// Steps the dense grid with the step functions, on a torus row by row so
+// the ghost columns are left to RefreshGhosts
+int CScreensaverBiogenesis::StepScalar(const Cell * cur, Cell * next)
+{
+  if (!m_grid.torus)
+    return StepRange(cur, next, 0, m_grid.width*m_grid.height);
+  int population = 0;
+  for (int y = 0; y < m_grid.height; y++)
+    population += StepRange(cur, next, y*m_grid.stride, y*m_grid.stride + m_grid.width);
+  return population;
+}
+
+// Steps the dense grid with the block table on the state planes. The table
+// only decides which cells live, the colors follow the step functions.
+int CScreensaverBiogenesis::StepTable(const Cell * cur, Cell * next)
+{
+  CLifeTable::Rule rule = CLifeTable::RULE_LIFE;
+  if (m_grid.ruleset)
+    rule = m_grid.colorType == COLOR_NEIGHBORS ? CLifeTable::RULE_LIFE_PATTERN : CLifeTable::RULE_LIFE_SIX;
+  CLifeTable& table = m_lifeTables[rule];
+  if (!table.IsBuilt(rule))
+    table.Build(rule);
+  if (m_planes[0].Width() != m_grid.width || m_planes[0].Height() != m_grid.height)
+  {
+    m_planes[0].Resize(m_grid.width, m_grid.height);
+    m_planes[1].Resize(m_grid.width, m_grid.height);
+    m_planeCurrent = false;
+  }
+  if (!m_planeCurrent)
+    m_planes[m_plane].Load(m_grid, cur);
+
+  const CStatePlane& now = m_planes[m_plane];
+  CStatePlane& after = m_planes[m_plane ^ 1];
+  table.Step(now, after);
+  after.RefreshBorder(m_grid.torus);
+
+  // Cells dead in both generations stay as they are, so rows are copied
+  // whole and only the cells alive in either are looked at. Unlike in
+  // StepLifetime a dead cell keeps its lifetime until it is born again,
+  // nothing reads it in between.
+  int stride = m_grid.stride;
+  int population = 0;
+  for (int y = 0; y < m_grid.height; y++)
+  {
+    memcpy(&next[y*stride], &cur[y*stride], m_grid.width*sizeof(Cell));
+    now.ForEachAlive(y, after, [&](int x)
+    {
+      int i = y*stride + x;
+      if (!after.Get(x, y))
+      {
+        next[i].state = DEAD;
+        if (m_grid.colorType == COLOR_NEIGHBORS)
+          next[i].color = m_grid.neighborColors[now.Neighbors(x, y)];
+        return;
+      }
+      population++;
+      if (cur[i].state == DEAD)
+      {
+        next[i].state = ALIVE;
+        if (m_grid.colorType == COLOR_TIME)
+        {
+          next[i].lifetime = 0;
+          next[i].color = m_grid.palette[0];
+        }
+        else if (m_grid.colorType == COLOR_NEIGHBORS)
+          next[i].color = m_grid.neighborColors[now.Neighbors(x, y)];
+        else
+        {
+          // The first three parents in the order StepColony finds them
+          const int order[8] = {-stride-1, -stride, -stride+1, -1, 1, stride-1, stride, stride+1};
+          CRGBA found[3];
+          for (int j = 0, count = 0; count < 3; j++)
+            if (cur[i + order[j]].state)
+              found[count++] = cur[i + order[j]].color;
+          next[i].color = found[0] == found[2] ? found[0] : found[1];
+        }
+      }
+      else if (m_grid.colorType == COLOR_TIME)
+      {
+        next[i].lifetime++;
+        if (next[i].lifetime >= m_grid.maxColor)
+          next[i].lifetime = m_grid.maxColor - 1;
+        next[i].color = m_grid.palette[next[i].lifetime];
+      }
+      else if (m_grid.colorType == COLOR_NEIGHBORS)
+        next[i].color = m_grid.neighborColors[now.Neighbors(x, y)];
+    });
+  }
+  m_plane ^= 1;
+  m_planeCurrent = true;
+  return population;
+}
+
+// The kernel choice for the coloring and size of the current grid
+CScreensaverBiogenesis::KernelChoice& CScreensaverBiogenesis::CurrentKernel()
+{
+  int cells = m_grid.width*m_grid.height;
+  int bucket = 0;
+  for (int limit = KERNEL_BUCKET_CELLS; bucket < KERNEL_SIZE_BUCKETS - 1 && cells >= limit; limit *= 4)
+    bucket++;
+  return m_kernels[m_grid.colorType][bucket];
+}
+
+// Steps the same generation with both kernels and times them, both write
+// the same cells. They take turns at going first, as the second one finds
+// the generation in the cache. Generations where the table kernel first has
+// to build its table or load the plane are not counted. After
+// KERNEL_SAMPLES generations the faster kernel is kept for grids of this
+// coloring and size.
+int CScreensaverBiogenesis::CalibrateKernels(const Cell * cur, Cell * next)
+{
+  KernelChoice& choice = CurrentKernel();
+  bool warm = m_planeCurrent;
+  bool tableFirst = choice.samples % 2 == 0;
+  float seconds[2];
+  int population = 0;
+  for (int k = 0; k < 2; k++)
+  {
+    bool table = (k == 0) == tableFirst;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    population = table ? StepTable(cur, next) : StepScalar(cur, next);
+    seconds[table] = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+  }
+  if (!warm)
+    return population;
+  choice.seconds[0] += seconds[0];
+  choice.seconds[1] += seconds[1];
+  if (++choice.samples == KERNEL_SAMPLES)
+  {
+    choice.kernel = choice.seconds[1] < choice.seconds[0] ? KERNEL_TABLE : KERNEL_SCALAR;
+    kodi::Log(ADDON_LOG_DEBUG, "Using the %s kernel on grids like %dx%d, "
+              "%.1f us scalar and %.1f us table per generation",
+              choice.kernel == KERNEL_TABLE ? "table" : "scalar", m_grid.width, m_grid.height,
+              choice.seconds[0] * 1e6f / KERNEL_SAMPLES, choice.seconds[1] * 1e6f / KERNEL_SAMPLES);
+  }
+  return population;
+}
+
+// Cells in one generation including its border and ghost cells
+int CScreensaverBiogenesis::GenerationSize() const
+{
+  return m_grid.stride*(m_grid.height+2)+2;
+}
+
+// Copies the opposite edges of a torus into the ghost columns and rows, so
+// the step functions can wrap around without any index arithmetic
+void CScreensaverBiogenesis::RefreshGhosts(Cell * cells)
+{
+  int stride = m_grid.stride;
+  for (int y = 0; y < m_grid.height; y++)
+  {
+    Cell * row = &cells[y*stride];
+    row[-1] = row[m_grid.width - 1];
+    row[m_grid.width] = row[0];
+  }
+  // Whole rows including their ghost columns, which also fills the corners
+  memcpy(&cells[-stride - 1], &cells[(m_grid.height - 1)*stride - 1], stride*sizeof(Cell));
+  memcpy(&cells[m_grid.height*stride - 1], &cells[-1], stride*sizeof(Cell));
+}
+
+// Steps the cells in [begin, end) of one generation into the other and
+// returns how many of them are alive afterwards
+int CScreensaverBiogenesis::StepRange(const Cell * cur, Cell * next, int begin, int end)
 {
   switch(m_grid.colorType)
   {
-    case COLOR_COLONY:    StepColony(); break;
-    case COLOR_TIME:    StepLifetime(); break;
-    case COLOR_NEIGHBORS:  StepNeighbors(); break;
+    case COLOR_COLONY:    return StepColony(cur, next, begin, end);
+    case COLOR_TIME:    return StepLifetime(cur, next, begin, end);
+    case COLOR_NEIGHBORS:  return StepNeighbors(cur, next, begin, end);
+  }
+  return 0;
+}
+
+// Advances the dense grid by several generations one band of rows at a
+// time. A band is copied together with the cells the generations can reach
+// from outside it and stepped in a local pair of buffers, which stay in the
+// cache, rather than streaming the whole grid through memory once per
+// generation. Every generation a band loses width+1 valid cells at each end
+// that does not touch the dead border, which the halo makes up for. Only
+// used on a bounded grid, where the stride equals the width.
+void CScreensaverBiogenesis::StepBlocked(int generations)
+{
+  m_planeCurrent = false;
+  int size = m_grid.width*m_grid.height;
+  int reach = m_grid.width + 1;
+  int halo = generations*reach;
+  int bandRows = BlockRows(generations);
+  if (bandRows == 0)
+    bandRows = generations + 1;
+  int bandCells = bandRows*m_grid.width;
+
+  // Each tile buffer has its own dead border in front of and behind the band
+  int tileSize = bandCells + 2*halo + 2*reach;
+  m_tileCells.resize(2*tileSize);
+  m_pendingCells.resize(bandCells);
+  int pendingBegin = 0, pendingEnd = 0;
+  int population = 0;
+
+  for (int begin = 0; begin < size; begin += bandCells)
+  {
+    int end = begin + bandCells < size ? begin + bandCells : size;
+    int lo = begin - halo > 0 ? begin - halo : 0;
+    int hi = end + halo < size ? end + halo : size;
+    // Tile index of a grid cell is its index plus offset
+    int offset = reach - lo;
+    Cell * cur = &m_tileCells[0];
+    Cell * next = &m_tileCells[tileSize];
+    memset(&cur[0], 0, reach*sizeof(Cell));
+    memset(&next[0], 0, reach*sizeof(Cell));
+    memset(&cur[hi + offset], 0, reach*sizeof(Cell));
+    memset(&next[hi + offset], 0, reach*sizeof(Cell));
+    memcpy(&cur[lo + offset], &m_grid.cells[lo], (hi - lo)*sizeof(Cell));
+
+    // The previous band's last but one generation can go back now that no
+    // later band reads the grid cells it overwrites
+    if (pendingEnd > pendingBegin)
+      memcpy(&m_grid.cells[pendingBegin], &m_pendingCells[0], (pendingEnd - pendingBegin)*sizeof(Cell));
+
+    int validBegin = lo, validEnd = hi;
+    for (int g = 0; g < generations; g++)
+    {
+      if (validBegin > 0)
+        validBegin += reach;
+      if (validEnd < size)
+        validEnd -= reach;
+      StepRange(cur, next, validBegin + offset, validEnd + offset);
+      Cell * temp = cur;
+      cur = next;
+      next = temp;
+    }
+
+    // The newest generation goes to the free buffer, the one before it is
+    // still needed by neighbor coloring
+    for (int i = begin; i < end; i++)
+      population += cur[i + offset].state;
+    memcpy(&m_grid.prevCells[begin], &cur[begin + offset], (end - begin)*sizeof(Cell));
+    memcpy(&m_pendingCells[0], &next[begin + offset], (end - begin)*sizeof(Cell));
+    pendingBegin = begin;
+    pendingEnd = end;
+  }
+  if (pendingEnd > pendingBegin)
+    memcpy(&m_grid.cells[pendingBegin], &m_pendingCells[0], (pendingEnd - pendingBegin)*sizeof(Cell));
+
+  m_grid.population = population;
+  SwapGenerations();
+}
+
+// Rows per band for StepBlocked, so that its working set fits into
+// BLOCK_CACHE_BYTES: two tiles of a band, its halo and the dead border
+// beyond, and the pending band. 0 if a band of more rows than generations
+// does not fit, as then the halo would be stepped more often than the band.
+int CScreensaverBiogenesis::BlockRows(int generations) const
+{
+  int reach = m_grid.width + 1;
+  int cells = BLOCK_CACHE_BYTES/(int)sizeof(Cell) - 2*(2*generations*reach + 2*reach);
+  int rows = cells/(3*m_grid.width);
+  return rows > generations ? rows : 0;
+}
+
+// Runs generations that are never drawn. Bands only pay off where a
+// generation does not fit into the cache anyway, which depends on the CPU
+// and the grid, so while the grid is dense the first block is stepped in
+// bands and the next one in single steps, both timed, and the faster of
+// the two runs the rest. Until the kernels are calibrated the single
+// steps would time both of them, so they run first. Wide grids take fewer
+// generations per block so a band still fits into the cache. A torus needs
+// its ghost cells refreshed every generation, so it always takes single
+// steps.
+void CScreensaverBiogenesis::FastForward(int generations)
+{
+  float seconds[2] = {}; // Per generation in single steps and in bands.
+  bool banded = false;
+  bool decided = false;
+  while (generations > 0)
+  {
+    int block = generations < BLOCK_GENERATIONS ? generations : BLOCK_GENERATIONS;
+    while (block > 1 && BlockRows(block) == 0)
+      block--;
+    if (m_sparse || m_grid.torus || CurrentKernel().kernel == KERNEL_UNKNOWN || block == 1 || (decided && !banded))
+    {
+      Step();
+      generations--;
+      continue;
+    }
+    if (decided)
+    {
+      StepBlocked(block);
+      SelectEngine();
+      generations -= block;
+      continue;
+    }
+
+    // Bands first, so the single steps find the grid in the cache if
+    // anything does, which favors them
+    bool bands = seconds[1] == 0.0f;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (bands)
+    {
+      StepBlocked(block);
+      SelectEngine();
+    }
+    else
+    {
+      for (int g = 0; g < block; g++)
+        Step();
+    }
+    seconds[bands] = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() / block;
+    generations -= block;
+    if (!bands)
+    {
+      decided = true;
+      banded = seconds[1] < seconds[0];
+      kodi::Log(ADDON_LOG_DEBUG, "Fast forwarding in %s, %.1f us single and %.1f us banded per generation",
+                banded ? "bands" : "single steps", seconds[0] * 1e6f, seconds[1] * 1e6f);
+    }
   }
 }
 
+// Moves the grid between the dense buffers and the live cell list when the
+// population density crosses the thresholds.
+void CScreensaverBiogenesis::SelectEngine()
+{
+  // The smallest cell sizes can leave a grid without any cells
+  int size = m_grid.width*m_grid.height;
+  if (size == 0)
+    return;
+  int permille = (int)(1000LL * m_grid.population / size);
+  if (!m_sparse && permille < SPARSE_ENTER_PERMILLE)
+    MakeSparse();
+  else if (m_sparse && permille > SPARSE_LEAVE_PERMILLE)
+    MakeDense();
+}
+
+void CScreensaverBiogenesis::MakeSparse()
+{
+  m_sparseGrid.Load(m_grid);
+  m_sparse = true;
+}
+
+void CScreensaverBiogenesis::MakeDense()
+{
+  m_sparseGrid.Store(m_grid);
+  m_sparseGrid.Clear();
+  m_planeCurrent = false;
+  if (m_grid.torus)
+    RefreshGhosts(m_grid.cells);
+  m_sparse = false;
+}
+
 CRGBA CScreensaverBiogenesis::HSVtoRGB( float h, float s, float v )
 {
   int i;
@@ -572,6 +1075,7 @@ CRGBA CScreensaverBiogenesis::HSVtoRGB( float h, float s, float v )
   return CRGBA(m,p,q,255);
 }
 
+#ifdef WIN32
 void CScreensaverBiogenesis::DrawRectangle(int x, int y, int w, int h, const CRGBA& dwColour)
 {
   //Store each point of the triangle together with it's colour
@@ -582,43 +1086,6 @@ void CScreensaverBiogenesis::DrawRectangle(int x, int y, int w, int h, const CRG
     {(float) x + w, (float) y + h, 0.0f, dwColour,},
     {(float) x + w, (float)     y, 0.0f, dwColour,},
   };
-#ifndef WIN32
-  EnableShader();
-
-  GLfloat x1 = -1.0 + 2.0*x/m_width;
-  GLfloat y1 = -1.0 + 2.0*y/m_height;
-  GLfloat x2 = -1.0 + 2.0*(x+w)/m_width;
-  GLfloat y2 = -1.0 + 2.0*(y+h)/m_height;
-
-  struct PackedVertex
-  {
-    GLfloat x, y, z;
-    GLfloat r, g, b;
-  } vertex[4] = {{x1, y1, 0.0, dwColour.r, dwColour.g, dwColour.b},
-                 {x2, y1, 0.0, dwColour.r, dwColour.g, dwColour.b},
-                 {x2, y2, 0.0, dwColour.r, dwColour.g, dwColour.b},
-                 {x1, y2, 0.0, dwColour.r, dwColour.g, dwColour.b}};
-
-  GLubyte idx[] = {0, 1, 2, 2, 3, 0};
-
-  glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(PackedVertex)*4, &vertex[0], GL_STATIC_DRAW);
-
-  glVertexAttribPointer(m_aPosition, 3, GL_FLOAT, 0, sizeof(PackedVertex), BUFFER_OFFSET(offsetof(PackedVertex, x)));
-  glVertexAttribPointer(m_aColor, 3, GL_FLOAT, 0, sizeof(PackedVertex), BUFFER_OFFSET(offsetof(PackedVertex, r)));
-
-  glEnableVertexAttribArray(m_aPosition);
-  glEnableVertexAttribArray(m_aColor);
-
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexVBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLubyte)*6, idx, GL_STATIC_DRAW);
-  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, 0);
-
-  glDisableVertexAttribArray(m_aPosition);
-  glDisableVertexAttribArray(m_aColor);
-
-  DisableShader();
-#else
   D3D11_MAPPED_SUBRESOURCE res = {};
   if (SUCCEEDED(g_pContext->Map(g_pVBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &res)))
   {
@@ -626,10 +1093,8 @@ void CScreensaverBiogenesis::DrawRectangle(int x, int y, int w, int h, const CRG
     g_pContext->Unmap(g_pVBuffer, 0);
   }
   g_pContext->Draw(4, 0);
-#endif
 }
 
-#ifdef WIN32
 const BYTE PixelShader[] =
 {
      68,  88,  66,  67,  18, 124,
@@ -715,7 +1180,15 @@ void CScreensaverBiogenesis::OnCompiledAndLinked()
 {
   // Variables passed directly to the Vertex shader
   m_aPosition = glGetAttribLocation(ProgramHandle(), "a_position");
-  m_aColor = glGetAttribLocation(ProgramHandle(), "a_color");
+  m_aColorFrom = glGetAttribLocation(ProgramHandle(), "a_colorFrom");
+  m_aColorTo = glGetAttribLocation(ProgramHandle(), "a_colorTo");
+  m_uInterpolation = glGetUniformLocation(ProgramHandle(), "u_interpolation");
+}
+
+bool CScreensaverBiogenesis::OnEnabled()
+{
+  glUniform1f(m_uInterpolation, m_interpolation);
+  return true;
 }
 #endif // WIN32
 
@@ -0,0 +1,199 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <kodi/addon-instance/Screensaver.h>
+
+#include "Grid.h"
+#include "LifeTable.h"
+#include "SparseGrid.h"
+#include "types.h"
+#include <chrono>
+#include <memory>
+#include <vector>
+#ifndef WIN32
+#include "GpuGrid.h"
+#include <kodi/gui/gl/GL.h>
+#include <kodi/gui/gl/Shader.h>
+#endif
+
+// The add-on settings as read from Kodi, replaced as a whole on changes
+struct Settings
+{
+  int minSize = 50;
+  int maxSize = 250;
+  int resetTime = 2000;
+  int stepRate = 15;
+  int presetChance = 30;
+  int cellLineLimit = 3;
+  int warmStart = 0;
+  bool torus = false;
+  bool gpu = false;
+  bool colony = true;
+  bool lifetime = true;
+  bool neighbour = true;
+};
+
+class ATTR_DLL_LOCAL CScreensaverBiogenesis
+  : public kodi::addon::CAddonBase
+  , public kodi::addon::CInstanceScreensaver
+#ifndef WIN32
+  , public kodi::gui::gl::CShaderProgram
+#endif
+{
+public:
+  CScreensaverBiogenesis();
+
+  // kodi::addon::CAddonBase
+  ADDON_STATUS SetSetting(const std::string& settingName,
+                          const kodi::addon::CSettingValue& settingValue) override;
+
+  // kodi::addon::CInstanceScreensaver
+  bool Start() override;
+  void Stop() override;
+  void Render() override;
+
+#ifndef WIN32
+  // kodi::gui::gl::CShaderProgram
+  void OnCompiledAndLinked() override;
+  bool OnEnabled() override;
+#endif
+
+private:
+  friend class CLifeTest; // The headless tests in tests/ step the engines directly.
+
+  static const int PALETTE_SIZE;
+  static const int MAX_COLOR;
+  static const int RESET_FRAME_RATE;
+  static const int SPARSE_ENTER_PERMILLE;
+  static const int SPARSE_LEAVE_PERMILLE;
+  static const int BLOCK_GENERATIONS;
+  static const int BLOCK_CACHE_BYTES;
+  static const int KERNEL_SAMPLES;
+  static const int KERNEL_SIZE_BUCKETS = 4;
+  static const int KERNEL_BUCKET_CELLS;
+
+  enum Kernel
+  {
+    KERNEL_UNKNOWN, // Both run until there are enough samples to pick one.
+    KERNEL_SCALAR,
+    KERNEL_TABLE,
+  };
+
+  // The kernel picked for one coloring and range of grid sizes, as the
+  // faster one differs between them
+  struct KernelChoice
+  {
+    Kernel kernel = KERNEL_UNKNOWN;
+    float seconds[2] = {}; // Scalar and table time while calibrating.
+    int samples = 0;
+  };
+
+  std::shared_ptr<const Settings> m_settings;
+  Grid m_grid = {};
+  int m_width;
+  int m_height;
+  float m_ratio;
+  std::chrono::steady_clock::time_point m_lastStep;
+  std::chrono::steady_clock::time_point m_createdTime;
+  bool m_firstFrameDrawn = false;
+  std::vector<Cell> m_cellStorage; // Backs m_grid.fullGrid, reused by every reset.
+  CSparseGrid m_sparseGrid;
+  std::vector<Cell> m_tileCells; // Both generations of a band in StepBlocked.
+  std::vector<Cell> m_pendingCells;
+  float m_ghostSeconds = 0.0f; // Time spent in RefreshGhosts since the last reset.
+  int m_ghostGenerations = 0;
+  bool m_sparse = false; // The current generation lives in m_sparseGrid.
+  bool m_gpu = false; // The current generation lives in m_gpuGrid.
+  KernelChoice m_kernels[3][KERNEL_SIZE_BUCKETS]; // Kept across resets, they depend on the CPU.
+  CLifeTable m_lifeTables[3]; // One per rule, each built on first use.
+  CStatePlane m_planes[2]; // States of the current and the next generation.
+  int m_plane = 0;
+  bool m_planeCurrent = false; // m_planes[m_plane] matches the current cells.
+  std::vector<CRGBA> m_shownColors; // Per cell color last uploaded, alpha 0 when dead.
+  std::vector<unsigned int> m_shownStamps; // Upload count a cell was last shown at.
+  std::vector<int> m_shownList; // Cells shown by the last upload.
+  std::vector<int> m_nextShownList;
+  unsigned int m_uploadCount = 0;
+
+  CRGBA randColor();
+  void LoadSettings();
+  void SeedGrid();
+  void presetPalette();
+  void CreateGrid();
+  void reducePalette();
+  template<typename F> void ForEachShownCell(F visit) const;
+  void UpdateGeometry();
+  void DrawGrid(float interpolation);
+  void SwapGenerations();
+  int GenerationSize() const;
+  void RefreshGhosts(Cell * cells);
+  int StepLifetime(const Cell * cur, Cell * next, int begin, int end);
+  int StepNeighbors(const Cell * cur, Cell * next, int begin, int end);
+  int StepColony(const Cell * cur, Cell * next, int begin, int end);
+  void Step();
+  void StepDense();
+  int StepScalar(const Cell * cur, Cell * next);
+  int StepTable(const Cell * cur, Cell * next);
+  KernelChoice& CurrentKernel();
+  int CalibrateKernels(const Cell * cur, Cell * next);
+  int StepRange(const Cell * cur, Cell * next, int begin, int end);
+  int BlockRows(int generations) const;
+  void StepBlocked(int generations);
+  void FastForward(int generations);
+  void SelectEngine();
+  void MakeSparse();
+  void MakeDense();
+  CRGBA HSVtoRGB( float h, float s, float v );
+#ifdef WIN32
+  void DrawRectangle(int x, int y, int w, int h, const CRGBA& dwColour);
+  void InitDXStuff(void);
+#else
+  struct PackedVertex
+  {
+    GLfloat x, y;
+    GLfloat from[4];
+    GLfloat to[4];
+  };
+
+  void AddQuad(int i, const CRGBA& from, const CRGBA& to);
+
+  GLint m_aPosition = -1;
+  GLint m_aColorFrom = -1;
+  GLint m_aColorTo = -1;
+  GLint m_uInterpolation = -1;
+  GLuint m_vertexVBO;
+  CGpuGrid m_gpuGrid;
+  bool m_gpuStarted = false;
+  GLsizei m_vertexCount = 0;
+  float m_interpolation = 0.0f;
+  std::vector<PackedVertex> m_vertices;
+#endif
+};
+
+// Neighbor coloring shows the generation before the current one, colored
+// by the neighborhood it had, so states come from the previous buffer.
+template<typename F>
+void CScreensaverBiogenesis::ForEachShownCell(F visit) const
+{
+  if (m_sparse)
+  {
+    for (const CSparseGrid::LiveCell& cell : m_sparseGrid.Shown(m_grid))
+      visit(cell.index, cell.color);
+    return;
+  }
+  const Cell * shown = m_grid.colorType == COLOR_NEIGHBORS ? m_grid.prevCells : m_grid.cells;
+  for(int y = 0; y<m_grid.height; y++ )
+  {
+    int row = y*m_grid.stride;
+    for(int x = 0; x<m_grid.width; x++ )
+      if (shown[row + x].state != DEAD)
+        visit(y*m_grid.width + x, m_grid.cells[row + x].color);
+  }
+}
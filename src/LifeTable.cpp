@@ -0,0 +1,154 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "LifeTable.h"
+
+#include <algorithm>
+
+void CStatePlane::Resize(int width, int height)
+{
+  m_width = width;
+  m_height = height;
+  // Border bits on both sides, three spare columns for the last window of
+  // an odd width, and a spare word
+  m_words = (width + 2 + 3 + 63) / 64 + 1;
+  // One spare row below for the last blocks of an odd height
+  m_bits.assign((height + 3)*m_words, 0);
+}
+
+void CStatePlane::Clear()
+{
+  std::fill(m_bits.begin(), m_bits.end(), 0);
+}
+
+void CStatePlane::Load(const Grid& grid, const Cell * cells)
+{
+  Clear();
+  for (int y = -1; y <= m_height; y++)
+    for (int x = -1; x <= m_width; x++)
+      if (cells[y*grid.stride + x].state != DEAD)
+        Set(x, y, true);
+}
+
+// Without wrapping, rows run into each other as in the dense grid: the left
+// border of a row is the last cell of the row above, the right border the
+// first cell of the row below, and the rest of the border stays dead.
+void CStatePlane::RefreshBorder(bool torus)
+{
+  int w = m_width, h = m_height;
+  std::fill(&Row(-1)[0], &Row(-1)[m_words], 0);
+  std::fill(&Row(h)[0], &Row(h)[m_words], 0);
+  if (torus)
+  {
+    for (int y = 0; y < h; y++)
+    {
+      Set(-1, y, Get(w - 1, y));
+      Set(w, y, Get(0, y));
+    }
+    std::copy(&Row(h - 1)[0], &Row(h - 1)[m_words], &Row(-1)[0]);
+    std::copy(&Row(0)[0], &Row(0)[m_words], &Row(h)[0]);
+    return;
+  }
+  for (int y = 0; y < h; y++)
+  {
+    Set(-1, y, y > 0 && Get(w - 1, y - 1));
+    Set(w, y, y < h - 1 && Get(0, y + 1));
+  }
+  Set(w, -1, Get(0, 0));
+  Set(-1, h, Get(w - 1, h - 1));
+}
+
+void CLifeTable::Build(Rule rule)
+{
+  m_rule = rule;
+  m_table.assign(1 << 16, 0);
+  for (int window = 0; window < (1 << 16); window++)
+  {
+    for (int block = 0; block < 4; block++)
+    {
+      // Window coordinates of the cell, the window starts one cell up left
+      int cx = 1 + (block & 1);
+      int cy = 1 + (block >> 1);
+      int neighbors = 0, count = 0, j = 0;
+      for (int dy = -1; dy <= 1; dy++)
+      {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+          if (dx == 0 && dy == 0)
+            continue;
+          if (window & (1 << ((cy + dy)*4 + cx + dx)))
+          {
+            neighbors |= 1 << j;
+            count++;
+          }
+          j++;
+        }
+      }
+      bool alive = (window & (1 << (cy*4 + cx))) != 0;
+      bool next;
+      if (alive)
+        next = count == 2 || count == 3;
+      else if (rule == RULE_LIFE_SIX)
+        next = count == 3 || count == 6;
+      else if (rule == RULE_LIFE_PATTERN)
+        next = count == 3 || neighbors == 0x7E || neighbors == 0xDB;
+      else
+        next = count == 3;
+      if (next)
+        m_table[window] |= 1 << block;
+    }
+  }
+}
+
+void CLifeTable::Step(const CStatePlane& cur, CStatePlane& next) const
+{
+  int w = cur.Width(), h = cur.Height();
+  int words = ((w - 1) >> 6) + 1;
+  const unsigned char * table = m_table.data();
+  for (int y = 0; y < h; y += 2)
+  {
+    const uint64_t * r0 = cur.Row(y - 1);
+    const uint64_t * r1 = cur.Row(y);
+    const uint64_t * r2 = cur.Row(y + 1);
+    const uint64_t * r3 = cur.Row(y + 2);
+    // An odd height leaves a lower row that is not part of the grid
+    uint64_t * upper = next.Row(y);
+    uint64_t * lower = y + 1 < h ? next.Row(y + 1) : next.Row(h + 1);
+    // Bit b of word k is cell 64*k+b-1. The window of the block at cell x
+    // starts at bit x and its cells land on bits x+1 and x+2, so the last
+    // block of a word carries its second cell over into the next word.
+    uint64_t carryUpper = 0, carryLower = 0;
+    for (int k = 0; k < words; k++)
+    {
+      uint64_t a = r0[k], b = r1[k], c = r2[k], d = r3[k];
+      uint64_t outUpper = carryUpper, outLower = carryLower;
+      for (int s = 0; s < 62; s += 2)
+      {
+        uint64_t block = table[(a >> s & 15) | (b >> s & 15) << 4 | (c >> s & 15) << 8 | (d >> s & 15) << 12];
+        outUpper |= (block & 3) << (s + 1);
+        outLower |= (block >> 2) << (s + 1);
+      }
+      a = a >> 62 | r0[k + 1] << 2;
+      b = b >> 62 | r1[k + 1] << 2;
+      c = c >> 62 | r2[k + 1] << 2;
+      d = d >> 62 | r3[k + 1] << 2;
+      uint64_t block = table[(a & 15) | (b & 15) << 4 | (c & 15) << 8 | (d & 15) << 12];
+      upper[k] = outUpper | (block & 1) << 63;
+      lower[k] = outLower | (block >> 2 & 1) << 63;
+      carryUpper = block >> 1 & 1;
+      carryLower = block >> 3;
+    }
+    upper[words] = carryUpper;
+    lower[words] = carryLower;
+    // Blocks past the last cell wrote into the right border and beyond,
+    // the border is left to RefreshBorder but the rest has to stay dead
+    next.ClearPastEnd(upper);
+    next.ClearPastEnd(lower);
+  }
+  std::fill(next.Row(h + 1), next.Row(h + 2), 0);
+}
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "Grid.h"
+
+#include <stdint.h>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////
+// The live state of a grid packed one bit per cell. Like the dense grid it
+// has a border column on either side of every row and a border row above
+// and below, which hold what the step functions would read there.
+//
+class CStatePlane
+{
+public:
+  void Resize(int width, int height);
+  // Copies the states of a dense grid including its border
+  void Load(const Grid& grid, const Cell * cells);
+  void Clear();
+  // Fills the border from the inside after the inside changed
+  void RefreshBorder(bool torus);
+
+  bool Get(int x, int y) const
+  {
+    int bit = x + 1;
+    return (Row(y)[bit >> 6] >> (bit & 63)) & 1;
+  }
+  void Set(int x, int y, bool alive)
+  {
+    int bit = x + 1;
+    uint64_t * row = Row(y);
+    row[bit >> 6] = (row[bit >> 6] & ~(1ULL << (bit & 63))) | ((uint64_t)alive << (bit & 63));
+  }
+  // Bits of the cells x .. x+3 in row y, lowest bit first
+  int Window(int x, int y) const
+  {
+    int bit = x + 1;
+    const uint64_t * row = Row(y);
+    uint64_t low = row[bit >> 6] >> (bit & 63);
+    uint64_t high = (row[(bit >> 6) + 1] << 1) << (63 - (bit & 63));
+    return (int)((low | high) & 0xF);
+  }
+  // Neighbor mask of a cell in the bit order of the step functions
+  int Neighbors(int x, int y) const
+  {
+    int above = Window(x - 1, y - 1) & 7;
+    int middle = Window(x - 1, y);
+    int below = Window(x - 1, y + 1) & 7;
+    return above | (middle & 1) << 3 | (middle & 4) << 2 | below << 5;
+  }
+
+  // Calls visit(x) for every cell of row y that is alive here or in other
+  template<typename F> void ForEachAlive(int y, const CStatePlane& other, F visit) const
+  {
+    const uint64_t * row = Row(y);
+    const uint64_t * otherRow = other.Row(y);
+    for (int k = 0; k*64 <= m_width; k++)
+    {
+      uint64_t bits = row[k] | otherRow[k];
+      // Drop the border bits at either end of the row
+      if (k == 0)
+        bits &= ~1ULL;
+      if (k == m_width >> 6)
+        bits &= (2ULL << (m_width & 63)) - 1;
+      while (bits)
+      {
+        visit(k*64 + LowestBit(bits) - 1);
+        bits &= bits - 1;
+      }
+    }
+  }
+
+  int Width() const { return m_width; }
+  int Height() const { return m_height; }
+
+private:
+  friend class CLifeTable;
+
+  // Clears a row from the bit after its right border on
+  void ClearPastEnd(uint64_t * row) const
+  {
+    int bit = m_width + 2;
+    row[bit >> 6] &= (1ULL << (bit & 63)) - 1;
+    for (int k = (bit >> 6) + 1; k < m_words; k++)
+      row[k] = 0;
+  }
+
+  static int LowestBit(uint64_t bits)
+  {
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return (int)index;
+#elif defined(_MSC_VER)
+    // 32 bit builds only have the 32 bit scan
+    unsigned long index;
+    if (_BitScanForward(&index, (unsigned long)bits))
+      return (int)index;
+    _BitScanForward(&index, (unsigned long)(bits >> 32));
+    return (int)index + 32;
+#else
+    return __builtin_ctzll(bits);
+#endif
+  }
+  const uint64_t * Row(int y) const { return &m_bits[(y + 1)*m_words]; }
+  uint64_t * Row(int y) { return &m_bits[(y + 1)*m_words]; }
+
+  int m_width = 0;
+  int m_height = 0;
+  int m_words = 0; // Words per row, one spare so Window can always read two.
+  std::vector<uint64_t> m_bits;
+};
+
+////////////////////////////////////////////////////////////////////////////
+// Steps a state plane two cells at a time in each direction. A 4x4 window
+// of cells holds the neighborhoods of the 2x2 block in its middle, so a
+// table indexed by the 16 window bits gives the next state of the block.
+//
+class CLifeTable
+{
+public:
+  enum Rule
+  {
+    RULE_LIFE, // Born with 3 neighbors, survives with 2 or 3.
+    RULE_LIFE_SIX, // Also born with 6 neighbors.
+    RULE_LIFE_PATTERN, // Also born with neighbor masks 0x7E and 0xDB.
+  };
+
+  void Build(Rule rule);
+  bool IsBuilt(Rule rule) const { return !m_table.empty() && m_rule == rule; }
+  // Writes the next state of the inside of the plane, the border is left
+  // to RefreshBorder
+  void Step(const CStatePlane& cur, CStatePlane& next) const;
+
+private:
+  Rule m_rule = RULE_LIFE;
+  // Bit 0 and 1 are the upper cells of a block, bits 2 and 3 the lower ones
+  std::vector<unsigned char> m_table;
+};
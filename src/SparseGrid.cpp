@@ -0,0 +1,226 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "SparseGrid.h"
+
+#include <algorithm>
+#include <memory.h>
+
+namespace
+{
+
+// Bit j of a neighbor mask is set when the cell NEIGHBOR_X[j] columns and
+// NEIGHBOR_Y[j] rows away lives
+const int NEIGHBOR_X[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+const int NEIGHBOR_Y[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+
+int CountBits(unsigned char bits)
+{
+  int count = 0;
+  for (; bits; bits &= bits - 1)
+    count++;
+  return count;
+}
+
+} // namespace
+
+void CSparseGrid::Clear()
+{
+  m_live.clear();
+  m_next.clear();
+  m_shown.clear();
+}
+
+// Live cells are indexed by y*width + x, dense cells by y*stride + x
+void CSparseGrid::Load(const Grid& grid)
+{
+  Clear();
+  for (int y = 0; y < grid.height; y++)
+  {
+    for (int x = 0; x < grid.width; x++)
+    {
+      const Cell& cell = grid.cells[y*grid.stride + x];
+      if (cell.state != DEAD)
+        m_live.push_back({y*grid.width + x, cell.lifetime, cell.color});
+      if (grid.colorType == COLOR_NEIGHBORS && grid.prevCells[y*grid.stride + x].state != DEAD)
+        m_shown.push_back({y*grid.width + x, 0, cell.color});
+    }
+  }
+}
+
+void CSparseGrid::Store(Grid& grid) const
+{
+  for (int y = -1; y <= grid.height; y++)
+  {
+    memset(&grid.cells[y*grid.stride - 1], 0, grid.stride*sizeof(Cell));
+    memset(&grid.prevCells[y*grid.stride - 1], 0, grid.stride*sizeof(Cell));
+  }
+  if (grid.colorType == COLOR_NEIGHBORS)
+  {
+    for (const LiveCell& cell : m_shown)
+    {
+      int i = (cell.index / grid.width)*grid.stride + cell.index % grid.width;
+      grid.prevCells[i].state = ALIVE;
+      grid.cells[i].color = cell.color;
+    }
+  }
+  for (const LiveCell& cell : m_live)
+  {
+    int i = (cell.index / grid.width)*grid.stride + cell.index % grid.width;
+    grid.cells[i].state = ALIVE;
+    grid.cells[i].lifetime = cell.lifetime;
+    grid.cells[i].color = cell.color;
+  }
+}
+
+// The indices of the neighbors of a cell in mask bit order, -1 for those in
+// the dead border. Without wrapping, rows run into each other as in the
+// dense grid. On a torus the row and column of the cell are worked out once
+// and the edges wrap by comparison.
+void CSparseGrid::Neighbors(const Grid& grid, int index, int (&neighbors)[8])
+{
+  int size = grid.width*grid.height;
+  if (!grid.torus)
+  {
+    for (int j = 0; j < 8; j++)
+    {
+      int neighbor = index + NEIGHBOR_Y[j]*grid.width + NEIGHBOR_X[j];
+      neighbors[j] = neighbor >= 0 && neighbor < size ? neighbor : -1;
+    }
+    return;
+  }
+  int y = index / grid.width;
+  int x = index - y*grid.width;
+  // Offsets to the column on the left, its own and the one on the right,
+  // and likewise to the rows above and below
+  const int columns[3] = {x > 0 ? -1 : grid.width - 1, 0, x < grid.width - 1 ? 1 : 1 - grid.width};
+  const int rows[3] = {y > 0 ? -grid.width : size - grid.width, 0, y < grid.height - 1 ? grid.width : grid.width - size};
+  for (int j = 0; j < 8; j++)
+    neighbors[j] = index + rows[NEIGHBOR_Y[j] + 1] + columns[NEIGHBOR_X[j] + 1];
+}
+
+void CSparseGrid::PrepareTable(size_t entries)
+{
+  // Keep the load factor at or below one half
+  size_t capacity = 16;
+  m_shift = 28;
+  while (capacity < entries * 2)
+  {
+    capacity *= 2;
+    m_shift--;
+  }
+  if (m_table.size() != capacity)
+    m_table.resize(capacity);
+  for (Slot& slot : m_table)
+    slot.key = EMPTY_KEY;
+  m_mask = static_cast<unsigned int>(capacity - 1);
+  m_used.clear();
+}
+
+CSparseGrid::Slot& CSparseGrid::Insert(int key)
+{
+  unsigned int pos = (static_cast<unsigned int>(key) * 0x9E3779B1u) >> m_shift;
+  while (m_table[pos].key != key)
+  {
+    if (m_table[pos].key == EMPTY_KEY)
+    {
+      m_table[pos].key = key;
+      m_table[pos].live = -1;
+      m_table[pos].neighbors = 0;
+      m_used.push_back(pos);
+      break;
+    }
+    pos = (pos + 1) & m_mask;
+  }
+  return m_table[pos];
+}
+
+const CSparseGrid::Slot* CSparseGrid::Find(int key) const
+{
+  unsigned int pos = (static_cast<unsigned int>(key) * 0x9E3779B1u) >> m_shift;
+  while (m_table[pos].key != EMPTY_KEY)
+  {
+    if (m_table[pos].key == key)
+      return &m_table[pos];
+    pos = (pos + 1) & m_mask;
+  }
+  return nullptr;
+}
+
+void CSparseGrid::Step(const Grid& grid)
+{
+  PrepareTable(m_live.size() * 9);
+  for (size_t k = 0; k < m_live.size(); k++)
+    Insert(m_live[k].index).live = static_cast<int>(k);
+
+  // A live cell is neighbor j of its own neighbor 7-j
+  int neighbors[8];
+  for (const LiveCell& cell : m_live)
+  {
+    Neighbors(grid, cell.index, neighbors);
+    for (int j = 0; j < 8; j++)
+    {
+      if (neighbors[7 - j] >= 0)
+        Insert(neighbors[7 - j]).neighbors |= 1 << j;
+    }
+  }
+
+  m_next.clear();
+  if (grid.colorType == COLOR_NEIGHBORS)
+    m_shown.clear();
+  for (int pos : m_used)
+  {
+    const Slot& slot = m_table[pos];
+    int count = CountBits(slot.neighbors);
+    if (slot.live >= 0)
+    {
+      LiveCell cell = m_live[slot.live];
+      bool survives = count == 2 || count == 3;
+      switch (grid.colorType)
+      {
+        case COLOR_TIME:
+          if (survives)
+          {
+            cell.lifetime++;
+            if (cell.lifetime >= grid.maxColor)
+              cell.lifetime = grid.maxColor - 1;
+            cell.color = grid.palette[cell.lifetime];
+          }
+          break;
+        case COLOR_NEIGHBORS:
+          cell.color = grid.neighborColors[slot.neighbors];
+          m_shown.push_back(cell);
+          break;
+      }
+      if (survives)
+        m_next.push_back(cell);
+    }
+    else if (grid.colorType == COLOR_NEIGHBORS)
+    {
+      if (count == 3 || (grid.ruleset && (slot.neighbors == 0x7E || slot.neighbors == 0xDB)))
+        m_next.push_back({slot.key, 0, grid.neighborColors[slot.neighbors]});
+    }
+    else if (count == 3 || (grid.ruleset && count == 6))
+    {
+      LiveCell cell = {slot.key, 0, grid.palette[0]};
+      if (grid.colorType == COLOR_COLONY)
+      {
+        // Majority of the first three parents in the dense scan order
+        CRGBA foundColors[3];
+        int found = 0;
+        Neighbors(grid, slot.key, neighbors);
+        for (int j = 0; j < 8 && found < 3; j++)
+          if (slot.neighbors & (1 << j))
+            foundColors[found++] = m_live[Find(neighbors[j])->live].color;
+        cell.color = foundColors[0] == foundColors[2] ? foundColors[0] : foundColors[1];
+      }
+      m_next.push_back(cell);
+    }
+  }
+  m_live.swap(m_next);
+}
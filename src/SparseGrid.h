@@ -0,0 +1,69 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "Grid.h"
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// Simulates a thinly populated grid from a list of its live cells. Each
+// step counts neighbors in an open addressing hash map keyed by the cell
+// index, so the cost follows the population instead of the grid size.
+// The neighborhood and the coloring rules are those of the dense step
+// functions, including the one generation lag of neighbor coloring.
+//
+class CSparseGrid
+{
+public:
+  struct LiveCell
+  {
+    int index;
+    short lifetime;
+    CRGBA color;
+  };
+
+  // Takes over the current generation of a dense grid
+  void Load(const Grid& grid);
+  // Writes the current generation back into both buffers of a dense grid
+  void Store(Grid& grid) const;
+  void Step(const Grid& grid);
+  void Clear();
+
+  int Population() const { return static_cast<int>(m_live.size()); }
+  // The cells DrawGrid shows, which differ from the live ones for neighbor
+  // coloring as that shows the generation before the current one.
+  const std::vector<LiveCell>& Shown(const Grid& grid) const
+  {
+    return grid.colorType == COLOR_NEIGHBORS ? m_shown : m_live;
+  }
+
+private:
+  struct Slot
+  {
+    int key; // Cell index, EMPTY_KEY when unused.
+    int live; // Index into m_live when the cell is alive, otherwise -1.
+    unsigned char neighbors; // Live neighbor bits in the dense kernel order.
+  };
+
+  static const int EMPTY_KEY = -1;
+
+  static void Neighbors(const Grid& grid, int index, int (&neighbors)[8]);
+  void PrepareTable(size_t entries);
+  Slot& Insert(int key);
+  const Slot* Find(int key) const;
+
+  std::vector<LiveCell> m_live;
+  std::vector<LiveCell> m_next;
+  std::vector<LiveCell> m_shown;
+  std::vector<Slot> m_table;
+  std::vector<int> m_used; // Occupied slots in insertion order.
+  unsigned int m_mask = 0;
+  int m_shift = 28; // Fibonacci hashing keeps the top bits of the product.
+};
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *  Copyright (C) 2004 Team XBMC
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+////////////////////////////////////////////////////////////////////////////
+// Neighbor masks use the bit order of the step functions:
+//
+//   0 1 2
+//   3 . 4
+//   5 6 7
+//
+// Masks that are rotations or mirror images of each other get the same
+// neighbor color. The table maps every mask to the smallest mask of its
+// symmetry class and is built by the compiler.
+//
+
+// Quarter turn, bit j of the result is bit ROTATE_SOURCE[j] of the input
+constexpr int ROTATE_SOURCE[8] = {2, 4, 7, 1, 6, 0, 3, 5};
+// Mirror along the vertical axis
+constexpr int FLIP_SOURCE[8] = {2, 1, 0, 4, 3, 7, 6, 5};
+
+constexpr int PermuteNeighbors(int bits, const int (&source)[8])
+{
+  int result = 0;
+  for (int j = 0; j < 8; j++)
+    result |= ((bits >> source[j]) & 1) << j;
+  return result;
+}
+
+constexpr int CanonicalNeighbors(int bits)
+{
+  int smallest = bits;
+  for (int flip = 0; flip < 2; flip++)
+  {
+    for (int turn = 0; turn < 4; turn++)
+    {
+      bits = PermuteNeighbors(bits, ROTATE_SOURCE);
+      if (bits < smallest)
+        smallest = bits;
+    }
+    bits = PermuteNeighbors(bits, FLIP_SOURCE);
+  }
+  return smallest;
+}
+
+struct SymmetryTable
+{
+  unsigned char canonical[256];
+};
+
+constexpr SymmetryTable MakeSymmetryTable()
+{
+  SymmetryTable table = {};
+  for (int i = 0; i < 256; i++)
+    table.canonical[i] = static_cast<unsigned char>(CanonicalNeighbors(i));
+  return table;
+}
+
+constexpr SymmetryTable NEIGHBOR_SYMMETRY = MakeSymmetryTable();
+
+static_assert(NEIGHBOR_SYMMETRY.canonical[0x01] == 0x01, "corners share a class");
+static_assert(NEIGHBOR_SYMMETRY.canonical[0x80] == 0x01, "corners share a class");
+static_assert(NEIGHBOR_SYMMETRY.canonical[0x40] == 0x02, "edges share a class");
+static_assert(NEIGHBOR_SYMMETRY.canonical[0xFF] == 0xFF, "full mask is its own class");
+
+// The reduction reducePalette used to run on every reset, which turns the
+// unpacked neighbor bits around in place. The table has to match it for
+// every mask, so neighbor colors stay as they were.
+constexpr void RotateBitsReference(int (&bits)[8])
+{
+  int temp = bits[0];
+  bits[0] = bits[2];
+  bits[2] = bits[7];
+  bits[7] = bits[5];
+  bits[5] = temp;
+  temp = bits[1];
+  bits[1] = bits[4];
+  bits[4] = bits[6];
+  bits[6] = bits[3];
+  bits[3] = temp;
+}
+
+constexpr void FlipBitsReference(int (&bits)[8])
+{
+  int temp = bits[0];
+  bits[0] = bits[2];
+  bits[2] = temp;
+  temp = bits[3];
+  bits[3] = bits[4];
+  bits[4] = temp;
+  temp = bits[5];
+  bits[5] = bits[7];
+  bits[7] = temp;
+}
+
+constexpr int ReduceNeighborsReference(int num)
+{
+  int bits[8] = {};
+  for (int i = 0; i < 8; i++)
+    bits[i] = (num & (1 << i)) >> i;
+  int inf = num;
+  for (int k = 0; k < 2; k++)
+  {
+    for (int j = 0; j < 4; j++)
+    {
+      RotateBitsReference(bits);
+      int packed = 0;
+      for (int i = 0; i < 8; i++)
+        packed |= bits[i] << i;
+      if (packed < inf)
+        inf = packed;
+    }
+    FlipBitsReference(bits);
+  }
+  return inf;
+}
+
+constexpr bool MatchesReference(const SymmetryTable& table, int begin, int end)
+{
+  for (int i = begin; i < end; i++)
+    if (table.canonical[i] != ReduceNeighborsReference(i))
+      return false;
+  return true;
+}
+
+// In quarters, to stay within the constexpr step limit of MSVC
+static_assert(MatchesReference(NEIGHBOR_SYMMETRY, 0, 64), "masks 0x00-0x3F match the old reduction");
+static_assert(MatchesReference(NEIGHBOR_SYMMETRY, 64, 128), "masks 0x40-0x7F match the old reduction");
+static_assert(MatchesReference(NEIGHBOR_SYMMETRY, 128, 192), "masks 0x80-0xBF match the old reduction");
+static_assert(MatchesReference(NEIGHBOR_SYMMETRY, 192, 256), "masks 0xC0-0xFF match the old reduction");
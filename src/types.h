@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <assert.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -0,0 +1,175 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+// Times a generation on each engine over a range of population densities
+// and reports where the sparse engine overtakes the dense ones, to check
+// the switching thresholds of CScreensaverBiogenesis against. Then times
+// fast forwarding in single steps, in bands, and the way FastForward picks.
+//
+// A random soup thins out within a few generations, so the grids are
+// seeded with still lifes and oscillators instead, which keep their
+// population and still see births and deaths every generation.
+
+#include "LifeTest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Each pattern sits in a tile of its own, far enough from the next one
+// that they never interact
+const int TILE = 6;
+// Block and blinker, cell offsets within the tile
+const int BLOCK[4][2] = {{1, 1}, {2, 1}, {1, 2}, {2, 2}};
+const int BLINKER[3][2] = {{1, 2}, {2, 2}, {3, 2}};
+
+const int DENSITIES[] = {1, 2, 5, 10, 15, 20, 25, 30, 40, 60, 100};
+const int WARMUP = 2;
+const int GENERATIONS = 10;
+const int REPEATS = 5;
+
+// The same minsize and maxsize, which fixes the cell size
+const CLifeTest::Screen SCREENS[] = {
+  {1920, 1080, 250, 250},
+  {1920, 1080, 500, 500},
+};
+
+// Live cells of a grid of patterns at roughly the given density
+std::vector<int> Patterns(const Grid& grid, int permille)
+{
+  std::vector<int> live;
+  float chance = permille / 1000.0f * TILE * TILE / 3.5f;
+  for (int y = 0; y + TILE <= grid.height; y += TILE)
+  {
+    for (int x = 0; x + TILE <= grid.width; x += TILE)
+    {
+      if (rand() >= chance * RAND_MAX)
+        continue;
+      if (rand() % 2)
+        for (const int (&cell)[2] : BLOCK)
+          live.push_back((y + cell[1])*grid.width + x + cell[0]);
+      else
+        for (const int (&cell)[2] : BLINKER)
+          live.push_back((y + cell[1])*grid.width + x + cell[0]);
+    }
+  }
+  return live;
+}
+
+// Microseconds per generation on an engine, the best of a few repeats
+float TimeEngine(CScreensaverBiogenesis& screensaver, CLifeTest::Engine engine, const std::vector<int>& live)
+{
+  float best = 0.0f;
+  for (int repeat = 0; repeat < REPEATS; repeat++)
+  {
+    CLifeTest::Reseed(screensaver, live);
+    CLifeTest::UseEngine(screensaver, engine);
+    for (int generation = 0; generation < WARMUP; generation++)
+      CLifeTest::StepEngine(screensaver);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int generation = 0; generation < GENERATIONS; generation++)
+      CLifeTest::StepEngine(screensaver);
+    float micros = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count() / GENERATIONS;
+    if (repeat == 0 || micros < best)
+      best = micros;
+  }
+  return best;
+}
+
+const int FAST_FORWARD = 64;
+const int BAND_GENERATIONS = 8;
+
+enum FastForwardWay
+{
+  WAY_SINGLE,
+  WAY_BANDS,
+  WAY_CHOSEN, // Whichever FastForward picks.
+};
+
+// Milliseconds to fast forward a freshly seeded grid one way, the best of
+// a few repeats
+float TimeFastForward(CScreensaverBiogenesis& screensaver, FastForwardWay way)
+{
+  float best = 0.0f;
+  for (int repeat = 0; repeat < REPEATS; repeat++)
+  {
+    srand(repeat);
+    CLifeTest::CreateGrid(screensaver);
+    CLifeTest::UseEngine(screensaver, CLifeTest::ENGINE_SCALAR);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (way == WAY_CHOSEN)
+      CLifeTest::FastForward(screensaver, FAST_FORWARD);
+    else if (way == WAY_BANDS)
+      for (int generation = 0; generation < FAST_FORWARD; generation += BAND_GENERATIONS)
+        CLifeTest::StepBlocked(screensaver, BAND_GENERATIONS);
+    else
+      for (int generation = 0; generation < FAST_FORWARD; generation++)
+        CLifeTest::Step(screensaver);
+    float millis = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (repeat == 0 || millis < best)
+      best = millis;
+  }
+  return best;
+}
+
+} /* namespace */
+
+int main()
+{
+  printf("The sparse engine takes over below %d and hands back above %d permille\n",
+         CLifeTest::SparseEnterPermille(), CLifeTest::SparseLeavePermille());
+  for (const CLifeTest::Screen& screen : SCREENS)
+  {
+    for (int colorType = 0; colorType < 3; colorType++)
+    {
+      CLifeTest::Configure(screen, colorType);
+      std::unique_ptr<CScreensaverBiogenesis> screensaver(new CScreensaverBiogenesis);
+      srand(1);
+      CLifeTest::CreateGrid(*screensaver);
+      const Grid& grid = CLifeTest::GetGrid(*screensaver);
+
+      printf("\n%dx%d grid, %s coloring, us per generation\n", grid.width, grid.height, CLifeTest::COLORINGS[colorType]);
+      printf("%9s %9s %9s %9s\n", "permille", "scalar", "table", "sparse");
+      int crossover = 0;
+      for (int permille : DENSITIES)
+      {
+        srand(permille);
+        std::vector<int> live = Patterns(grid, permille);
+        float scalar = TimeEngine(*screensaver, CLifeTest::ENGINE_SCALAR, live);
+        float table = TimeEngine(*screensaver, CLifeTest::ENGINE_TABLE, live);
+        float sparse = TimeEngine(*screensaver, CLifeTest::ENGINE_SPARSE, live);
+        float actual = 1000.0f * live.size() / (grid.width*grid.height);
+        printf("%9.1f %9.1f %9.1f %9.1f\n", actual, scalar, table, sparse);
+        if (sparse < std::min(scalar, table))
+          crossover = permille;
+      }
+      printf("The sparse engine is faster up to about %d permille\n", crossover);
+    }
+  }
+
+  printf("\nFast forwarding %d generations of a random soup, ms\n", FAST_FORWARD);
+  printf("%9s %9s %9s %9s\n", "grid", "single", "bands", "chosen");
+  for (const CLifeTest::Screen& screen : SCREENS)
+  {
+    CLifeTest::Configure(screen, COLOR_TIME);
+    std::unique_ptr<CScreensaverBiogenesis> screensaver(new CScreensaverBiogenesis);
+    float single = TimeFastForward(*screensaver, WAY_SINGLE);
+    float bands = TimeFastForward(*screensaver, WAY_BANDS);
+    float chosen = TimeFastForward(*screensaver, WAY_CHOSEN);
+    const Grid& grid = CLifeTest::GetGrid(*screensaver);
+    std::string size = std::to_string(grid.width) + "x" + std::to_string(grid.height);
+    printf("%9s %9.1f %9.1f %9.1f\n", size.c_str(), single, bands, chosen);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,392 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+// Steps the screensaver next to the engine it replaced, and its engines
+// next to each other, and compares every generation.
+
+#include "LifeTest.h"
+#include "Symmetry.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////
+// The step functions as they were before the generations were ping-ponged.
+// A single buffer holds both the state and the next state of every cell,
+// UpdateStates copies one into the other after each step, and neighbor
+// coloring reduces the palette itself. Only knows the bounded grid.
+//
+class CReferenceGrid
+{
+public:
+  // Takes over the seeded grid and the palette of a screensaver
+  explicit CReferenceGrid(const Grid& grid);
+
+  void Step();
+  CLifeTest::Snapshot Take() const;
+
+private:
+  struct Cell
+  {
+    CRGBA color;
+    short lifetime;
+    char state;
+    char nextstate;
+  };
+
+  void ReducePalette();
+  void UpdateStates();
+  void StepLifetime();
+  void StepNeighbors();
+  void StepColony();
+
+  int m_width;
+  int m_height;
+  int m_colorType;
+  int m_ruleset;
+  int m_maxColor;
+  CRGBA m_palette[sizeof(Grid::palette)/sizeof(CRGBA)];
+  std::vector<Cell> m_fullGrid;
+  Cell * m_cells;
+};
+
+CReferenceGrid::CReferenceGrid(const Grid& grid)
+  : m_width(grid.width),
+    m_height(grid.height),
+    m_colorType(grid.colorType),
+    m_ruleset(grid.ruleset),
+    m_maxColor(grid.maxColor),
+    m_fullGrid(grid.width*(grid.height + 2) + 2)
+{
+  for (size_t i = 0; i < sizeof(m_palette)/sizeof(CRGBA); i++)
+    m_palette[i] = grid.palette[i];
+  if (m_colorType == COLOR_NEIGHBORS)
+    ReducePalette();
+
+  memset(m_fullGrid.data(), 0, m_fullGrid.size()*sizeof(Cell));
+  m_cells = &m_fullGrid[m_width + 1];
+  for (int i = 0; i < m_width*m_height; i++)
+  {
+    const ::Cell& seeded = grid.cells[i];
+    m_cells[i].color = seeded.color;
+    m_cells[i].lifetime = seeded.lifetime;
+    m_cells[i].state = seeded.state;
+    m_cells[i].nextstate = seeded.state;
+  }
+}
+
+// Symmetry.h keeps the old reduction to check its table against
+void CReferenceGrid::ReducePalette()
+{
+  for (int i = 0; i < 256; i++)
+    m_palette[i] = m_palette[ReduceNeighborsReference(i)];
+}
+
+void CReferenceGrid::Step()
+{
+  switch (m_colorType)
+  {
+    case COLOR_COLONY:    StepColony(); break;
+    case COLOR_TIME:      StepLifetime(); break;
+    case COLOR_NEIGHBORS: StepNeighbors(); break;
+  }
+}
+
+// The cells DrawGrid used to show are those alive in the state field,
+// which for neighbor coloring is still the generation before
+CLifeTest::Snapshot CReferenceGrid::Take() const
+{
+  CLifeTest::Snapshot snapshot;
+  for (int i = 0; i < m_width*m_height; i++)
+  {
+    if (m_cells[i].state != DEAD)
+      snapshot.shown.emplace_back(i, m_cells[i].color.RenderColor());
+    char current = m_colorType == COLOR_NEIGHBORS ? m_cells[i].nextstate : m_cells[i].state;
+    if (current != DEAD)
+      snapshot.live.emplace_back(i, m_colorType == COLOR_TIME ? m_cells[i].lifetime : 0);
+  }
+  return snapshot;
+}
+
+void CReferenceGrid::UpdateStates()
+{
+  for (int i = 0; i < m_width*m_height; i++)
+    m_cells[i].state = m_cells[i].nextstate;
+}
+
+void CReferenceGrid::StepLifetime()
+{
+  for (int i = 0; i < m_width*m_height; i++)
+  {
+    int count = 0;
+    if (m_cells[i-m_width-1].state) count++;
+    if (m_cells[i-m_width  ].state) count++;
+    if (m_cells[i-m_width+1].state) count++;
+    if (m_cells[i        -1].state) count++;
+    if (m_cells[i        +1].state) count++;
+    if (m_cells[i+m_width-1].state) count++;
+    if (m_cells[i+m_width  ].state) count++;
+    if (m_cells[i+m_width+1].state) count++;
+
+    if (m_cells[i].state == DEAD)
+    {
+      m_cells[i].lifetime = 0;
+      if (count == 3 || (m_ruleset && count == 6))
+      {
+        m_cells[i].nextstate = ALIVE;
+        m_cells[i].color = m_palette[0];
+      }
+    }
+    else
+    {
+      if (count == 2 || count == 3)
+      {
+        m_cells[i].lifetime++;
+        if (m_cells[i].lifetime >= m_maxColor)
+          m_cells[i].lifetime = m_maxColor - 1;
+        m_cells[i].color = m_palette[m_cells[i].lifetime];
+      }
+      else
+        m_cells[i].nextstate = DEAD;
+    }
+  }
+  UpdateStates();
+}
+
+void CReferenceGrid::StepNeighbors()
+{
+  UpdateStates();
+  for (int i = 0; i < m_width*m_height; i++)
+  {
+    int count = 0;
+    int neighbors = 0;
+    if (m_cells[i-m_width-1].state) {count++; neighbors |=  1;}
+    if (m_cells[i-m_width  ].state) {count++; neighbors |=  2;}
+    if (m_cells[i-m_width+1].state) {count++; neighbors |=  4;}
+    if (m_cells[i        -1].state) {count++; neighbors |=  8;}
+    if (m_cells[i        +1].state) {count++; neighbors |= 16;}
+    if (m_cells[i+m_width-1].state) {count++; neighbors |= 32;}
+    if (m_cells[i+m_width  ].state) {count++; neighbors |= 64;}
+    if (m_cells[i+m_width+1].state) {count++; neighbors |=128;}
+
+    if (m_cells[i].state == DEAD)
+    {
+      if (count == 3 || (m_ruleset && (neighbors == 0x7E || neighbors == 0xDB)))
+      {
+        m_cells[i].nextstate = ALIVE;
+        m_cells[i].color = m_palette[neighbors];
+      }
+    }
+    else
+    {
+      if (count != 2 && count != 3)
+        m_cells[i].nextstate = DEAD;
+      m_cells[i].color = m_palette[neighbors];
+    }
+  }
+}
+
+void CReferenceGrid::StepColony()
+{
+  CRGBA foundColors[8];
+  for (int i = 0; i < m_width*m_height; i++)
+  {
+    int count = 0;
+    if (m_cells[i-m_width-1].state) foundColors[count++] = m_cells[i-m_width-1].color;
+    if (m_cells[i-m_width  ].state) foundColors[count++] = m_cells[i-m_width  ].color;
+    if (m_cells[i-m_width+1].state) foundColors[count++] = m_cells[i-m_width+1].color;
+    if (m_cells[i        -1].state) foundColors[count++] = m_cells[i        -1].color;
+    if (m_cells[i        +1].state) foundColors[count++] = m_cells[i        +1].color;
+    if (m_cells[i+m_width-1].state) foundColors[count++] = m_cells[i+m_width-1].color;
+    if (m_cells[i+m_width  ].state) foundColors[count++] = m_cells[i+m_width  ].color;
+    if (m_cells[i+m_width+1].state) foundColors[count++] = m_cells[i+m_width+1].color;
+
+    if (m_cells[i].state == DEAD)
+    {
+      if (count == 3 || (m_ruleset && count == 6))
+      {
+        if (foundColors[0] == foundColors[2])
+          m_cells[i].color = foundColors[0];
+        else
+          m_cells[i].color = foundColors[1];
+        m_cells[i].nextstate = ALIVE;
+      }
+    }
+    else if (count != 2 && count != 3)
+      m_cells[i].nextstate = DEAD;
+  }
+  UpdateStates();
+}
+
+const CLifeTest::Screen SCREENS[] = {
+  {640, 480, 20, 40},
+  {1280, 720, 100, 150},
+  {300, 200, 5, 10},
+  {1920, 1080, 60, 80},
+};
+
+const char * const KERNELS[3] = {"timed", "scalar", "table"};
+
+const int GENERATIONS = 300;
+const int SEEDS = 2;
+
+// Steps one screensaver and the reference from the same seeded grid and
+// returns false at the first generation where what they show differs
+bool CompareWithReference(const CLifeTest::Screen& screen, int colorType, int ruleset, int kernel, int seed)
+{
+  CLifeTest::Configure(screen, colorType);
+
+  std::unique_ptr<CScreensaverBiogenesis> screensaver(new CScreensaverBiogenesis);
+  if (kernel)
+    CLifeTest::UseKernel(*screensaver, kernel == 2);
+  srand(seed);
+  CLifeTest::CreateGrid(*screensaver);
+  Grid& grid = CLifeTest::GetGrid(*screensaver);
+  grid.ruleset = ruleset;
+  CReferenceGrid reference(grid);
+
+  for (int generation = 1; generation <= GENERATIONS; generation++)
+  {
+    CLifeTest::Step(*screensaver);
+    reference.Step();
+    if (CLifeTest::Take(*screensaver) != reference.Take())
+    {
+      printf("%dx%d grid, %s coloring, ruleset %d, %s kernel, seed %d: generation %d differs\n",
+             grid.width, grid.height, CLifeTest::COLORINGS[colorType], ruleset, KERNELS[kernel], seed, generation);
+      return false;
+    }
+  }
+  return true;
+}
+
+const char * const ENGINES[3] = {"scalar", "table", "sparse"};
+
+// Generations the mixed run stays on each engine before moving on
+const int ENGINE_SPAN = 37;
+
+// Steps the same seeded grid on each engine alone, and once moving from
+// one engine to the next every ENGINE_SPAN generations, and returns false
+// at the first generation where one differs from the scalar kernel
+bool CompareEngines(const CLifeTest::Screen& screen, int colorType, bool torus, int seed)
+{
+  CLifeTest::Configure(screen, colorType, torus);
+
+  // The last one is the mixed run
+  std::vector<std::unique_ptr<CScreensaverBiogenesis>> screensavers;
+  for (int engine = 0; engine <= 3; engine++)
+  {
+    screensavers.emplace_back(new CScreensaverBiogenesis);
+    srand(seed);
+    CLifeTest::CreateGrid(*screensavers.back());
+    CLifeTest::UseEngine(*screensavers.back(), (CLifeTest::Engine)(engine % 3));
+  }
+
+  for (int generation = 1; generation <= GENERATIONS; generation++)
+  {
+    int mixed = generation / ENGINE_SPAN % 3;
+    CLifeTest::UseEngine(*screensavers[3], (CLifeTest::Engine)mixed);
+    for (auto& screensaver : screensavers)
+      CLifeTest::StepEngine(*screensaver);
+
+    CLifeTest::Snapshot expected = CLifeTest::Take(*screensavers[0]);
+    int population = CLifeTest::GetGrid(*screensavers[0]).population;
+    for (int engine = 1; engine <= 3; engine++)
+    {
+      if (CLifeTest::Take(*screensavers[engine]) != expected ||
+          CLifeTest::GetGrid(*screensavers[engine]).population != population)
+      {
+        const Grid& grid = CLifeTest::GetGrid(*screensavers[0]);
+        printf("%dx%d %s grid, %s coloring, seed %d: generation %d differs on the %s%s engine\n",
+               grid.width, grid.height, torus ? "torus" : "bounded", CLifeTest::COLORINGS[colorType], seed,
+               generation, engine == 3 ? "mixed run's " : "", ENGINES[engine == 3 ? mixed : engine]);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+const int BLOCKS[] = {1, 2, 3, 5, 8};
+const int BLOCK_ROUNDS = 4;
+
+// Steps the same seeded bounded grid in blocks of generations and one
+// generation at a time, and returns false at the first block after which
+// they differ. The wide screens need bands of fewer rows than generations.
+bool CompareBlocked(const CLifeTest::Screen& screen, int colorType, int generations, int seed)
+{
+  CLifeTest::Configure(screen, colorType);
+
+  std::unique_ptr<CScreensaverBiogenesis> blocked(new CScreensaverBiogenesis);
+  std::unique_ptr<CScreensaverBiogenesis> single(new CScreensaverBiogenesis);
+  srand(seed);
+  CLifeTest::CreateGrid(*blocked);
+  srand(seed);
+  CLifeTest::CreateGrid(*single);
+  CLifeTest::UseEngine(*blocked, CLifeTest::ENGINE_SCALAR);
+  CLifeTest::UseEngine(*single, CLifeTest::ENGINE_SCALAR);
+
+  for (int round = 1; round <= BLOCK_ROUNDS; round++)
+  {
+    CLifeTest::StepBlocked(*blocked, generations);
+    for (int generation = 0; generation < generations; generation++)
+      CLifeTest::StepEngine(*single);
+    if (CLifeTest::Take(*blocked) != CLifeTest::Take(*single) ||
+        CLifeTest::GetGrid(*blocked).population != CLifeTest::GetGrid(*single).population)
+    {
+      const Grid& grid = CLifeTest::GetGrid(*single);
+      printf("%dx%d grid, %s coloring, seed %d: block %d of %d generations differs\n",
+             grid.width, grid.height, CLifeTest::COLORINGS[colorType], seed, round, generations);
+      return false;
+    }
+  }
+  return true;
+}
+
+} /* namespace */
+
+int main()
+{
+  int runs = 0, failures = 0;
+  for (const CLifeTest::Screen& screen : SCREENS)
+    for (int colorType = 0; colorType < 3; colorType++)
+      for (int ruleset = 0; ruleset < 2; ruleset++)
+        for (int kernel = 0; kernel < 3; kernel++)
+          for (int seed = 1; seed <= SEEDS; seed++, runs++)
+            if (!CompareWithReference(screen, colorType, ruleset, kernel, seed))
+              failures++;
+  printf("Reference comparison: %d of %d runs of %d generations differ\n", failures, runs, GENERATIONS);
+
+  int engineRuns = 0, engineFailures = 0;
+  for (const CLifeTest::Screen& screen : SCREENS)
+    for (int colorType = 0; colorType < 3; colorType++)
+      for (int torus = 0; torus < 2; torus++)
+        for (int seed = 1; seed <= SEEDS; seed++, engineRuns++)
+          if (!CompareEngines(screen, colorType, torus != 0, seed))
+            engineFailures++;
+  printf("Engine comparison: %d of %d runs of %d generations differ\n", engineFailures, engineRuns, GENERATIONS);
+
+  // A grid 960 cells wide, on which the bands are cut down
+  std::vector<CLifeTest::Screen> blockScreens(std::begin(SCREENS), std::end(SCREENS));
+  blockScreens.push_back({1920, 1080, 500, 500});
+  int blockedRuns = 0, blockedFailures = 0;
+  for (const CLifeTest::Screen& screen : blockScreens)
+    for (int colorType = 0; colorType < 3; colorType++)
+      for (int generations : BLOCKS)
+        for (int seed = 1; seed <= SEEDS; seed++, blockedRuns++)
+          if (!CompareBlocked(screen, colorType, generations, seed))
+            blockedFailures++;
+  printf("Blocked comparison: %d of %d runs of %d blocks differ\n", blockedFailures, blockedRuns, BLOCK_ROUNDS);
+
+  return failures || engineFailures || blockedFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+// Steps the GPU engine next to the scalar kernel and compares every
+// generation it reads back, then draws both and compares the frames.
+// Skipped where EGL has no OpenGL ES 2 context to offer; Mesa's llvmpipe
+// is enough.
+
+#include "Headless.h"
+#include "LifeTest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+const CLifeTest::Screen SCREENS[] = {
+  {640, 480, 20, 40},
+  {300, 200, 5, 10},
+  {1920, 1080, 60, 80},
+};
+
+const int GENERATIONS = 300;
+const int SEEDS = 2;
+
+// Steps the same seeded grid on the GPU and on the CPU and returns false
+// at the first generation where what they show differs
+bool CompareGpu(const CLifeTest::Screen& screen, int colorType, bool torus, int ruleset, int seed)
+{
+  CLifeTest::Configure(screen, colorType, torus);
+  std::unique_ptr<CScreensaverBiogenesis> cpu(new CScreensaverBiogenesis);
+  srand(seed);
+  CLifeTest::CreateGrid(*cpu);
+  CLifeTest::UseEngine(*cpu, CLifeTest::ENGINE_SCALAR);
+
+  CLifeTest::Configure(screen, colorType, torus, true);
+  std::unique_ptr<CScreensaverBiogenesis> gpu(new CScreensaverBiogenesis);
+  if (!CLifeTest::StartGpu(*gpu))
+  {
+    printf("The GPU shaders failed to build\n");
+    return false;
+  }
+  srand(seed);
+  CLifeTest::CreateGrid(*gpu);
+  const Grid& grid = CLifeTest::GetGrid(*cpu);
+  if (!CLifeTest::OnGpu(*gpu))
+  {
+    printf("%dx%d grid did not move to the GPU\n", grid.width, grid.height);
+    return false;
+  }
+  CLifeTest::GetGrid(*cpu).ruleset = ruleset;
+  CLifeTest::GetGrid(*gpu).ruleset = ruleset;
+
+  for (int generation = 1; generation <= GENERATIONS; generation++)
+  {
+    CLifeTest::Step(*cpu);
+    CLifeTest::Step(*gpu);
+    if (CLifeTest::Take(*gpu) != CLifeTest::Take(*cpu))
+    {
+      printf("%dx%d %s grid, %s coloring, ruleset %d, seed %d: generation %d differs\n",
+             grid.width, grid.height, torus ? "torus" : "bounded", CLifeTest::COLORINGS[colorType], ruleset,
+             seed, generation);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Small enough to read back every frame, with and without spacing
+const CLifeTest::Screen DRAW_SCREENS[] = {
+  {640, 480, 20, 40},
+  {300, 200, 5, 10},
+  {800, 600, 100, 150},
+};
+
+const int DRAW_GENERATIONS = 40;
+const float INTERPOLATIONS[] = {0.0f, 0.5f, 1.0f};
+// The shaders mix colors at different precisions
+const int DRAW_TOLERANCE = 2;
+
+// An offscreen target the size of the screen the screensavers draw on
+class CTarget
+{
+public:
+  CTarget(int width, int height) : m_width(width), m_height(height), m_pixels(width*height*4)
+  {
+    glGenTextures(1, &m_texture);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
+    glViewport(0, 0, width, height);
+  }
+
+  ~CTarget()
+  {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &m_framebuffer);
+    glDeleteTextures(1, &m_texture);
+  }
+
+  // Draws a frame of a screensaver and reads it back
+  const std::vector<unsigned char>& Draw(CScreensaverBiogenesis& screensaver, float interpolation)
+  {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    CLifeTest::Draw(screensaver, interpolation);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_pixels.data());
+    return m_pixels;
+  }
+
+private:
+  int m_width;
+  int m_height;
+  GLuint m_texture = 0;
+  GLuint m_framebuffer = 0;
+  std::vector<unsigned char> m_pixels;
+};
+
+// Draws the same seeded grid with the GPU shader and with the cell quads
+// after every generation, part of the way through the cross-fade too, and
+// returns false at the first frame where a pixel is further apart than
+// DRAW_TOLERANCE in a color channel
+bool CompareDrawn(const CLifeTest::Screen& screen, int colorType, bool torus, int seed)
+{
+  CLifeTest::Configure(screen, colorType, torus);
+  std::unique_ptr<CScreensaverBiogenesis> cpu(new CScreensaverBiogenesis);
+  srand(seed);
+  cpu->Start();
+  CLifeTest::Configure(screen, colorType, torus, true);
+  std::unique_ptr<CScreensaverBiogenesis> gpu(new CScreensaverBiogenesis);
+  srand(seed);
+  gpu->Start();
+  const Grid& grid = CLifeTest::GetGrid(*cpu);
+  bool same = CLifeTest::OnGpu(*gpu);
+  if (!same)
+    printf("%dx%d grid did not move to the GPU\n", grid.width, grid.height);
+
+  CTarget target(screen.width, screen.height);
+  std::vector<unsigned char> expected;
+  for (int generation = 1; same && generation <= DRAW_GENERATIONS; generation++)
+  {
+    CLifeTest::Advance(*cpu);
+    CLifeTest::Advance(*gpu);
+    for (float interpolation : INTERPOLATIONS)
+    {
+      expected = target.Draw(*cpu, interpolation);
+      const std::vector<unsigned char>& drawn = target.Draw(*gpu, interpolation);
+      for (size_t i = 0; same && i < drawn.size(); i++)
+      {
+        if (i % 4 != 3 && abs(drawn[i] - expected[i]) > DRAW_TOLERANCE)
+        {
+          int pixel = (int)(i / 4);
+          printf("%dx%d %s grid, %s coloring, seed %d: generation %d at %.1f differs at %d,%d\n",
+                 grid.width, grid.height, torus ? "torus" : "bounded", CLifeTest::COLORINGS[colorType], seed,
+                 generation, interpolation, pixel % screen.width, pixel / screen.width);
+          same = false;
+        }
+      }
+    }
+  }
+  cpu->Stop();
+  gpu->Stop();
+  return same;
+}
+
+} /* namespace */
+
+int main()
+{
+  if (!headless::CreateContext(64, 64))
+  {
+    printf("No OpenGL ES 2 context, skipped\n");
+    return headless::SKIPPED;
+  }
+
+  int runs = 0, failures = 0;
+  for (const CLifeTest::Screen& screen : SCREENS)
+    for (int colorType = 0; colorType < 3; colorType++)
+      for (int torus = 0; torus < 2; torus++)
+        for (int ruleset = 0; ruleset < 2; ruleset++)
+          for (int seed = 1; seed <= SEEDS; seed++, runs++)
+            if (!CompareGpu(screen, colorType, torus != 0, ruleset, seed))
+              failures++;
+  printf("GPU comparison: %d of %d runs of %d generations differ\n", failures, runs, GENERATIONS);
+
+  int drawRuns = 0, drawFailures = 0;
+  for (const CLifeTest::Screen& screen : DRAW_SCREENS)
+    for (int colorType = 0; colorType < 3; colorType++)
+      for (int torus = 0; torus < 2; torus++, drawRuns++)
+        if (!CompareDrawn(screen, colorType, torus != 0, 1))
+          drawFailures++;
+  printf("Drawn comparison: %d of %d runs of %d generations differ\n", drawFailures, drawRuns, DRAW_GENERATIONS);
+
+  return failures || drawFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "Headless.h"
+#include "Life.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////
+// Steps a screensaver the way Render does and reads back the generations
+// it produces, whichever engine currently holds them, the GPU included.
+//
+class CLifeTest
+{
+public:
+  // The cells DrawGrid shows with their colors, and the live cells of the
+  // current generation with their lifetimes, both by cell index. Neighbor
+  // coloring shows the generation before the current one, so the two
+  // differ there.
+  struct Snapshot
+  {
+    std::vector<std::pair<int, u32>> shown;
+    std::vector<std::pair<int, int>> live;
+
+    bool operator==(const Snapshot& other) const
+    {
+      return shown == other.shown && live == other.live;
+    }
+    bool operator!=(const Snapshot& other) const { return !(*this == other); }
+  };
+
+  // A screen and the range of cell counts asked for across it
+  struct Screen
+  {
+    int width;
+    int height;
+    int minSize;
+    int maxSize;
+  };
+
+  // Setting names by color type
+  static constexpr const char * COLORINGS[3] = {"lifetime", "colony", "neighbour"};
+
+  // Sets the screen and the settings screensavers created afterwards read,
+  // with only the given coloring allowed
+  static void Configure(const Screen& screen, int colorType, bool torus = false, bool gpu = false, int warmStart = 0)
+  {
+    headless::SetScreen(screen.width, screen.height);
+    headless::ClearSettings();
+    headless::SetSetting("minsize", std::to_string(screen.minSize));
+    headless::SetSetting("maxsize", std::to_string(screen.maxSize));
+    headless::SetSetting("torus", torus ? "true" : "false");
+    headless::SetSetting("gpu", gpu ? "true" : "false");
+    headless::SetSetting("warmstart", std::to_string(warmStart));
+    for (int i = 0; i < 3; i++)
+      headless::SetSetting(COLORINGS[i], i == colorType ? "true" : "false");
+  }
+
+  enum Engine
+  {
+    ENGINE_SCALAR, // The dense grid with the step functions.
+    ENGINE_TABLE, // The dense grid with the block table.
+    ENGINE_SPARSE,
+  };
+
+  static Grid& GetGrid(CScreensaverBiogenesis& screensaver) { return screensaver.m_grid; }
+  static void CreateGrid(CScreensaverBiogenesis& screensaver) { screensaver.CreateGrid(); }
+  static void Step(CScreensaverBiogenesis& screensaver) { screensaver.Step(); }
+  static int SparseEnterPermille() { return CScreensaverBiogenesis::SPARSE_ENTER_PERMILLE; }
+  static int SparseLeavePermille() { return CScreensaverBiogenesis::SPARSE_LEAVE_PERMILLE; }
+
+  // Builds the GPU engine the way Start does, so grids created afterwards
+  // move over to it if the gpu setting is on. Needs a current GL context.
+  static bool StartGpu(CScreensaverBiogenesis& screensaver)
+  {
+    screensaver.m_gpuStarted = screensaver.m_gpuGrid.Start();
+    return screensaver.m_gpuStarted;
+  }
+  static bool OnGpu(const CScreensaverBiogenesis& screensaver) { return screensaver.m_gpu; }
+
+  // Steps a generation and rebuilds the cell quads, as Render does once a
+  // step is due
+  static void Advance(CScreensaverBiogenesis& screensaver)
+  {
+    screensaver.Step();
+    screensaver.UpdateGeometry();
+  }
+
+  // Draws the cells part of the way from the last generation shown to the
+  // newest one
+  static void Draw(CScreensaverBiogenesis& screensaver, float interpolation)
+  {
+    screensaver.DrawGrid(interpolation);
+  }
+
+  // Makes the next Render step a generation, as if its period had passed
+  static void DueStep(CScreensaverBiogenesis& screensaver)
+  {
+    screensaver.m_lastStep = std::chrono::steady_clock::time_point();
+  }
+
+  // Makes the next Render create the grid anew, as if its time was up
+  static void DueReset(CScreensaverBiogenesis& screensaver)
+  {
+    screensaver.m_grid.frameCounter = screensaver.m_grid.resetTime;
+    DueStep(screensaver);
+  }
+
+  // Keeps dense grids of every coloring and size on one kernel instead of
+  // timing both first
+  static void UseKernel(CScreensaverBiogenesis& screensaver, bool table)
+  {
+    for (auto& choices : screensaver.m_kernels)
+      for (CScreensaverBiogenesis::KernelChoice& choice : choices)
+        choice.kernel = table ? CScreensaverBiogenesis::KERNEL_TABLE : CScreensaverBiogenesis::KERNEL_SCALAR;
+  }
+
+  // Moves the grid over to an engine, which then steps it until another
+  // one is asked for, whatever the population
+  static void UseEngine(CScreensaverBiogenesis& screensaver, Engine engine)
+  {
+    if (engine == ENGINE_SPARSE)
+    {
+      if (!screensaver.m_sparse)
+        screensaver.MakeSparse();
+      return;
+    }
+    if (screensaver.m_sparse)
+      screensaver.MakeDense();
+    UseKernel(screensaver, engine == ENGINE_TABLE);
+  }
+
+  // Steps with the engine the grid is on, without switching
+  static void StepEngine(CScreensaverBiogenesis& screensaver)
+  {
+    if (screensaver.m_sparse)
+    {
+      screensaver.m_sparseGrid.Step(screensaver.m_grid);
+      screensaver.m_grid.population = screensaver.m_sparseGrid.Population();
+    }
+    else
+      screensaver.StepDense();
+  }
+
+  // Advances a bounded dense grid by several generations in bands
+  static void StepBlocked(CScreensaverBiogenesis& screensaver, int generations)
+  {
+    screensaver.StepBlocked(generations);
+  }
+
+  // Runs undrawn generations the way a warm start does
+  static void FastForward(CScreensaverBiogenesis& screensaver, int generations)
+  {
+    screensaver.FastForward(generations);
+  }
+
+  // Replaces both generations by a dense grid holding the given cells,
+  // each alive with a random color
+  static void Reseed(CScreensaverBiogenesis& screensaver, const std::vector<int>& live)
+  {
+    Grid& grid = screensaver.m_grid;
+    screensaver.m_sparse = false;
+    screensaver.m_sparseGrid.Clear();
+    screensaver.m_planeCurrent = false;
+    memset(grid.fullGrid, 0, 2*screensaver.GenerationSize()*sizeof(Cell));
+    for (int i : live)
+    {
+      Cell& cell = grid.cells[(i / grid.width)*grid.stride + i % grid.width];
+      cell.state = ALIVE;
+      cell.color = grid.colorType == COLOR_TIME ? grid.palette[0] : screensaver.randColor();
+    }
+    grid.population = (int)live.size();
+    if (grid.torus)
+      screensaver.RefreshGhosts(grid.cells);
+  }
+
+  static Snapshot Take(CScreensaverBiogenesis& screensaver)
+  {
+    // The dense buffers are stale while the GPU steps the grid and are
+    // only read again once a reset seeds them, so both generations are
+    // read back into them
+    if (screensaver.m_gpu)
+      screensaver.m_gpuGrid.Store(screensaver.m_grid);
+
+    Snapshot snapshot;
+    screensaver.ForEachShownCell([&snapshot](int i, const CRGBA& color) {
+      snapshot.shown.emplace_back(i, color.RenderColor());
+    });
+    std::sort(snapshot.shown.begin(), snapshot.shown.end());
+
+    // The other engines leave the dense buffers behind, so their current
+    // generation is written into a copy of the grid
+    const Grid& grid = screensaver.m_grid;
+    const Cell * cells = grid.cells;
+    Grid copy;
+    std::vector<Cell> storage;
+    if (screensaver.m_sparse)
+    {
+      int generationSize = screensaver.GenerationSize();
+      copy = grid;
+      storage.resize(2*generationSize);
+      copy.cells = &storage[grid.stride + 1];
+      copy.prevCells = &storage[generationSize + grid.stride + 1];
+      screensaver.m_sparseGrid.Store(copy);
+      cells = copy.cells;
+    }
+    for (int y = 0; y < grid.height; y++)
+    {
+      for (int x = 0; x < grid.width; x++)
+      {
+        const Cell& cell = cells[y*grid.stride + x];
+        if (cell.state != DEAD)
+          snapshot.live.emplace_back(y*grid.width + x, grid.colorType == COLOR_TIME ? cell.lifetime : 0);
+      }
+    }
+    return snapshot;
+  }
+};
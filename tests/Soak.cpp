@@ -0,0 +1,335 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+// Runs screensavers through Start, Render and Stop on random screens,
+// cell sizes and color modes, resetting their grid over and over. The
+// same configurations run twice: the first lap warms up the driver and
+// the buffers that are kept, so the second one must not hold on to more
+// memory or allocate more often, in total or in any one reset. With
+// --latency it must not take longer to reset either, which depends on
+// the machine being otherwise idle.
+//
+//   soak [--configs N] [--resets N] [--generations N] [--seed N] [--gpu] [--latency]
+
+#include "Headless.h"
+#include "LifeTest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace
+{
+
+// Counts of the allocator below. Mesa compiles shaders on threads of its
+// own, some of which allocate through it too.
+std::atomic<long long> g_allocations(0);
+std::atomic<long long> g_liveBytes(0);
+
+// Bytes held by a block, only known to glibc
+size_t BlockSize(void * block)
+{
+#ifdef __GLIBC__
+  return malloc_usable_size(block);
+#else
+  (void)block;
+  return 0;
+#endif
+}
+
+void * Allocate(size_t size)
+{
+  void * block = malloc(size ? size : 1);
+  if (block)
+  {
+    g_allocations++;
+    g_liveBytes += (long long)BlockSize(block);
+  }
+  return block;
+}
+
+void Free(void * block)
+{
+  if (!block)
+    return;
+  g_liveBytes -= (long long)BlockSize(block);
+  free(block);
+}
+
+} /* namespace */
+
+void * operator new(size_t size)
+{
+  void * block = Allocate(size);
+  if (!block)
+    throw std::bad_alloc();
+  return block;
+}
+
+void * operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  return Allocate(size);
+}
+
+void operator delete(void * block) noexcept
+{
+  Free(block);
+}
+
+void operator delete(void * block, size_t) noexcept
+{
+  Free(block);
+}
+
+void operator delete(void * block, const std::nothrow_t&) noexcept
+{
+  Free(block);
+}
+
+namespace
+{
+
+struct Options
+{
+  int configs = 12;
+  int resets = 4;
+  int generations = 20;
+  unsigned seed = 1;
+  bool gpu = false;
+  bool latency = false; // Also compare the time resets take.
+};
+
+struct Config
+{
+  CLifeTest::Screen screen;
+  int colorType;
+  bool torus;
+  int warmStart;
+  unsigned seed;
+};
+
+struct Lap
+{
+  long long liveBytes = 0; // Still held at the end of the lap.
+  long long allocations = 0;
+  long peakKiB = 0;
+  float resetMillis = 0.0f; // Summed over all resets.
+  float worstResetMillis = 0.0f;
+  int resets = 0;
+  // Allocations by each reset after the first of a screensaver, which finds
+  // its buffers in place
+  std::vector<long long> resetAllocations;
+};
+
+// The sizes span the whole range of the settings in either order, which
+// covers cells rounding down to nothing and cells larger than the screen
+const int MAX_SIZE = 500;
+const int MAX_WARM_START = 64;
+
+// Allowances for the second lap over the first
+const long long LIVE_SLACK_BYTES = 64 * 1024;
+const float ALLOCATION_SLACK = 0.1f;
+// The kernel timings can pick the table kernel in one lap and not the
+// other, which sizes its two state planes on the next grid of a new size
+const long long RESET_ALLOCATION_SLACK = 4;
+const long RSS_SLACK_KIB = 8 * 1024;
+const float RESET_SLACK = 1.5f;
+const float RESET_SLACK_MILLIS = 1.0f;
+
+std::vector<Config> MakeConfigs(const Options& options)
+{
+  std::mt19937 random(options.seed);
+  std::vector<Config> configs;
+  for (int i = 0; i < options.configs; i++)
+  {
+    Config config;
+    CLifeTest::Screen& screen = config.screen;
+    screen.width = std::uniform_int_distribution<int>(200, 3840)(random);
+    screen.height = std::uniform_int_distribution<int>(200, 2160)(random);
+    if (random() % 4 == 0)
+      std::swap(screen.width, screen.height);
+    screen.minSize = std::uniform_int_distribution<int>(1, MAX_SIZE)(random);
+    screen.maxSize = std::uniform_int_distribution<int>(1, MAX_SIZE)(random);
+    config.colorType = i % 3;
+    config.torus = random() % 2 != 0;
+    config.warmStart = random() % 4 == 0 ? (int)(random() % MAX_WARM_START) : 0;
+    config.seed = random();
+    configs.push_back(config);
+  }
+  return configs;
+}
+
+long PeakKiB()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+bool Run(const Config& config, const Options& options, Lap& lap)
+{
+  CLifeTest::Configure(config.screen, config.colorType, config.torus, options.gpu, config.warmStart);
+
+  srand(config.seed);
+  std::unique_ptr<CScreensaverBiogenesis> screensaver(new CScreensaverBiogenesis);
+  if (!screensaver->Start())
+  {
+    printf("%dx%d screen failed to start\n", config.screen.width, config.screen.height);
+    return false;
+  }
+  for (int reset = 0; reset < options.resets; reset++)
+  {
+    long long allocations = g_allocations;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    CLifeTest::DueReset(*screensaver);
+    screensaver->Render();
+    glFinish();
+    float millis = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (reset > 0)
+      lap.resetAllocations.push_back(g_allocations - allocations);
+    lap.resetMillis += millis;
+    if (millis > lap.worstResetMillis)
+      lap.worstResetMillis = millis;
+    lap.resets++;
+
+    for (int generation = 0; generation < options.generations; generation++)
+    {
+      CLifeTest::DueStep(*screensaver);
+      screensaver->Render();
+    }
+    glFinish();
+  }
+  screensaver->Stop();
+  return true;
+}
+
+bool RunLap(const std::vector<Config>& configs, const Options& options, Lap& lap)
+{
+  long long liveBytes = g_liveBytes;
+  long long allocations = g_allocations;
+  for (const Config& config : configs)
+    if (!Run(config, options, lap))
+      return false;
+  lap.liveBytes = g_liveBytes - liveBytes;
+  lap.allocations = g_allocations - allocations;
+  lap.peakKiB = PeakKiB();
+  return true;
+}
+
+void PrintLap(const char * name, const Lap& lap)
+{
+  long long resetAllocations = 0;
+  for (long long allocations : lap.resetAllocations)
+    resetAllocations = std::max(resetAllocations, allocations);
+  printf("%6s %12lld %12lld %10lld %10.1f %10.2f %10.2f\n", name, lap.liveBytes / 1024, lap.allocations,
+         resetAllocations, lap.peakKiB / 1024.0f, lap.resets ? lap.resetMillis / lap.resets : 0.0f,
+         lap.worstResetMillis);
+}
+
+bool ParseOptions(int argc, char * argv[], Options& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    std::string option = argv[i];
+    if (option == "--gpu")
+      options.gpu = true;
+    else if (option == "--latency")
+      options.latency = true;
+    else if (i + 1 < argc && option == "--configs")
+      options.configs = atoi(argv[++i]);
+    else if (i + 1 < argc && option == "--resets")
+      options.resets = atoi(argv[++i]);
+    else if (i + 1 < argc && option == "--generations")
+      options.generations = atoi(argv[++i]);
+    else if (i + 1 < argc && option == "--seed")
+      options.seed = (unsigned)atoi(argv[++i]);
+    else
+      return false;
+  }
+  return options.configs > 0 && options.resets > 0 && options.generations >= 0;
+}
+
+} /* namespace */
+
+int main(int argc, char * argv[])
+{
+  Options options;
+  if (!ParseOptions(argc, argv, options))
+  {
+    printf("Usage: %s [--configs N] [--resets N] [--generations N] [--seed N] [--gpu] [--latency]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+#ifdef __GLIBC__
+  // glibc raises its mmap threshold as large blocks are freed, after which
+  // grids of the second lap come from a fragmented heap instead of pages of
+  // their own and the peak grows without anything being kept
+  mallopt(M_MMAP_THRESHOLD, 128 * 1024);
+#endif
+  if (!headless::CreateContext(64, 64))
+  {
+    printf("No OpenGL ES 2 context, skipped\n");
+    return headless::SKIPPED;
+  }
+
+  std::vector<Config> configs = MakeConfigs(options);
+  Lap first, second;
+  if (!RunLap(configs, options, first) || !RunLap(configs, options, second))
+    return EXIT_FAILURE;
+
+  printf("%d screens, %d resets of %d generations each%s\n", options.configs, options.resets,
+         options.generations, options.gpu ? " on the GPU" : "");
+  printf("%6s %12s %12s %10s %10s %10s %10s\n", "lap", "kept KiB", "allocations", "per reset", "peak MiB",
+         "reset ms", "worst ms");
+  PrintLap("first", first);
+  PrintLap("second", second);
+
+  bool failed = false;
+  if (second.liveBytes > LIVE_SLACK_BYTES)
+  {
+    printf("The second lap kept %lld KiB after every screensaver was gone\n", second.liveBytes / 1024);
+    failed = true;
+  }
+  if (second.allocations > first.allocations * (1.0f + ALLOCATION_SLACK))
+  {
+    printf("The second lap allocated %lld times, the first %lld\n", second.allocations, first.allocations);
+    failed = true;
+  }
+  if (second.peakKiB > first.peakKiB + RSS_SLACK_KIB)
+  {
+    printf("The peak resident size grew by %ld KiB in the second lap\n", second.peakKiB - first.peakKiB);
+    failed = true;
+  }
+  // Both laps run the same resets in the same order
+  for (size_t i = 0; i < second.resetAllocations.size(); i++)
+  {
+    if (second.resetAllocations[i] > first.resetAllocations[i] + RESET_ALLOCATION_SLACK)
+    {
+      printf("Reset %d allocated %lld times in the second lap, %lld in the first\n", (int)i,
+             second.resetAllocations[i], first.resetAllocations[i]);
+      failed = true;
+    }
+  }
+  float firstReset = first.resetMillis / first.resets;
+  float secondReset = second.resetMillis / second.resets;
+  if (options.latency && secondReset > firstReset * RESET_SLACK + RESET_SLACK_MILLIS)
+  {
+    printf("Resets took %.2f ms in the second lap, %.2f ms in the first\n", secondReset, firstReset);
+    failed = true;
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "Headless.h"
+
+#include <kodi/addon-instance/Screensaver.h>
+#include <kodi/gui/gl/Shader.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstdarg>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace
+{
+int g_width = 1920;
+int g_height = 1080;
+bool g_verbose = false;
+std::map<std::string, std::string> g_settings;
+
+bool ReadFile(const std::string& path, std::string& contents)
+{
+  std::ifstream file(path);
+  if (!file)
+    return false;
+  std::stringstream stream;
+  stream << file.rdbuf();
+  contents = stream.str();
+  return true;
+}
+
+GLuint CompileShader(GLenum type, const std::string& source)
+{
+  GLuint shader = glCreateShader(type);
+  const char* text = source.c_str();
+  glShaderSource(shader, 1, &text, nullptr);
+  glCompileShader(shader);
+  GLint compiled = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+  if (!compiled)
+  {
+    char log[4096];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    kodi::Log(ADDON_LOG_ERROR, "Shader compilation failed: %s", log);
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+} /* namespace */
+
+namespace headless
+{
+
+void SetScreen(int width, int height)
+{
+  g_width = width;
+  g_height = height;
+}
+
+void SetSetting(const std::string& name, const std::string& value)
+{
+  g_settings[name] = value;
+}
+
+void ClearSettings()
+{
+  g_settings.clear();
+}
+
+void SetVerbose(bool verbose)
+{
+  g_verbose = verbose;
+}
+
+bool CreateContext(int width, int height)
+{
+  // Without a window system Mesa still renders on its surfaceless platform
+  EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+  {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (!getPlatformDisplay)
+      return false;
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+      return false;
+  }
+  const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                                     EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+                                     EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+                                     EGL_NONE};
+  EGLConfig config;
+  EGLint configs = 0;
+  if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs < 1)
+    return false;
+  const EGLint surfaceAttributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+  EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+  if (surface == EGL_NO_SURFACE || !eglBindAPI(EGL_OPENGL_ES_API))
+    return false;
+  const EGLint contextAttributes[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+  EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+  if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context))
+    return false;
+  glViewport(0, 0, width, height);
+  kodi::Log(ADDON_LOG_DEBUG, "Rendering with %s", glGetString(GL_RENDERER));
+  return true;
+}
+
+} /* namespace headless */
+
+void kodi::Log(const AddonLog loglevel, const char* format, ...)
+{
+  if (loglevel == ADDON_LOG_DEBUG && !g_verbose)
+    return;
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
+
+std::string kodi::addon::GetAddonPath(const std::string& append)
+{
+  return BIOGENESIS_ADDON_DIR + append;
+}
+
+int kodi::addon::GetSettingInt(const std::string& settingName, int defaultValue)
+{
+  auto setting = g_settings.find(settingName);
+  return setting == g_settings.end() ? defaultValue : CSettingValue(setting->second).GetInt();
+}
+
+bool kodi::addon::GetSettingBoolean(const std::string& settingName, bool defaultValue)
+{
+  auto setting = g_settings.find(settingName);
+  return setting == g_settings.end() ? defaultValue : CSettingValue(setting->second).GetBoolean();
+}
+
+int kodi::addon::CSettingValue::GetInt() const
+{
+  return std::stoi(m_settingValue);
+}
+
+bool kodi::addon::CSettingValue::GetBoolean() const
+{
+  return m_settingValue == "true";
+}
+
+int kodi::addon::CInstanceScreensaver::Width()
+{
+  return g_width;
+}
+
+int kodi::addon::CInstanceScreensaver::Height()
+{
+  return g_height;
+}
+
+kodi::gui::gl::CShaderProgram::~CShaderProgram()
+{
+  if (m_shaderProgram)
+    glDeleteProgram(m_shaderProgram);
+}
+
+bool kodi::gui::gl::CShaderProgram::LoadShaderFiles(const std::string& vert, const std::string& frag)
+{
+  if (!ReadFile(vert, m_vertexSource) || !ReadFile(frag, m_fragmentSource))
+  {
+    kodi::Log(ADDON_LOG_ERROR, "Failed to read %s or %s", vert.c_str(), frag.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool kodi::gui::gl::CShaderProgram::CompileAndLink(const std::string& vertexExtraBegin,
+                                                   const std::string& vertexExtraEnd,
+                                                   const std::string& fragmentExtraBegin,
+                                                   const std::string& fragmentExtraEnd)
+{
+  GLuint vertex = CompileShader(GL_VERTEX_SHADER, vertexExtraBegin + m_vertexSource + vertexExtraEnd);
+  GLuint fragment = CompileShader(GL_FRAGMENT_SHADER, fragmentExtraBegin + m_fragmentSource + fragmentExtraEnd);
+  if (!vertex || !fragment)
+    return false;
+
+  m_shaderProgram = glCreateProgram();
+  glAttachShader(m_shaderProgram, vertex);
+  glAttachShader(m_shaderProgram, fragment);
+  glLinkProgram(m_shaderProgram);
+  glDeleteShader(vertex);
+  glDeleteShader(fragment);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(m_shaderProgram, GL_LINK_STATUS, &linked);
+  if (!linked)
+  {
+    kodi::Log(ADDON_LOG_ERROR, "Shader program failed to link");
+    return false;
+  }
+  m_ok = true;
+  OnCompiledAndLinked();
+  return true;
+}
+
+bool kodi::gui::gl::CShaderProgram::EnableShader()
+{
+  if (!m_ok)
+    return false;
+  glUseProgram(m_shaderProgram);
+  if (OnEnabled())
+    return true;
+  glUseProgram(0);
+  return false;
+}
+
+void kodi::gui::gl::CShaderProgram::DisableShader()
+{
+  if (m_ok)
+  {
+    glUseProgram(0);
+    OnDisabled();
+  }
+}
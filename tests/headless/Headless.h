@@ -0,0 +1,32 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <string>
+
+////////////////////////////////////////////////////////////////////////////
+// Controls what the stand-in Kodi API reports to the screensaver. Screens
+// and settings apply to screensavers created afterwards, like in Kodi.
+//
+namespace headless
+{
+
+void SetScreen(int width, int height);
+// Booleans are "true" or "false", as Kodi stores them
+void SetSetting(const std::string& name, const std::string& value);
+void ClearSettings();
+// Debug messages are dropped unless asked for, errors always go to stderr
+void SetVerbose(bool verbose);
+// Makes an OpenGL ES 2 context with an offscreen surface current, which
+// drawing and the GPU engine need, false if EGL cannot provide one
+bool CreateContext(int width, int height);
+
+// Exit code ctest reports a test as skipped on
+const int SKIPPED = 77;
+
+} /* namespace headless */
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+// Stands in for the parts of the Kodi add-on API the screensaver uses, so
+// it can be built and run without Kodi. Implemented in Headless.cpp.
+
+#include <string>
+
+#define ATTR_DLL_LOCAL
+
+typedef enum AddonLog
+{
+  ADDON_LOG_DEBUG = 0,
+  ADDON_LOG_INFO = 1,
+  ADDON_LOG_WARNING = 2,
+  ADDON_LOG_ERROR = 3,
+  ADDON_LOG_FATAL = 4
+} AddonLog;
+
+typedef enum ADDON_STATUS
+{
+  ADDON_STATUS_OK,
+  ADDON_STATUS_LOST_CONNECTION,
+  ADDON_STATUS_NEED_RESTART,
+  ADDON_STATUS_NEED_SETTINGS,
+  ADDON_STATUS_UNKNOWN,
+  ADDON_STATUS_PERMANENT_FAILURE,
+  ADDON_STATUS_NOT_IMPLEMENTED
+} ADDON_STATUS;
+
+namespace kodi
+{
+
+void Log(const AddonLog loglevel, const char* format, ...);
+
+namespace addon
+{
+
+std::string GetAddonPath(const std::string& append = "");
+int GetSettingInt(const std::string& settingName, int defaultValue = 0);
+bool GetSettingBoolean(const std::string& settingName, bool defaultValue = false);
+
+class CSettingValue
+{
+public:
+  explicit CSettingValue(const std::string& settingValue) : m_settingValue(settingValue) {}
+
+  int GetInt() const;
+  bool GetBoolean() const;
+
+private:
+  std::string m_settingValue;
+};
+
+class CAddonBase
+{
+public:
+  virtual ~CAddonBase() = default;
+
+  virtual ADDON_STATUS SetSetting(const std::string& settingName,
+                                  const CSettingValue& settingValue)
+  {
+    return ADDON_STATUS_UNKNOWN;
+  }
+};
+
+} /* namespace addon */
+} /* namespace kodi */
+
+// The tests create the screensaver themselves
+#define ADDONCREATOR(AddonClass)
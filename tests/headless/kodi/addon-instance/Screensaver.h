@@ -0,0 +1,33 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "../AddonBase.h"
+
+namespace kodi
+{
+namespace addon
+{
+
+class CInstanceScreensaver
+{
+public:
+  virtual ~CInstanceScreensaver() = default;
+
+  virtual bool Start() { return true; }
+  virtual void Stop() {}
+  virtual void Render() {}
+
+  // The screen set with headless::SetScreen
+  int Width();
+  int Height();
+  void* Device() { return nullptr; }
+};
+
+} /* namespace addon */
+} /* namespace kodi */
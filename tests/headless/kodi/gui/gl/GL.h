@@ -0,0 +1,16 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+// The headless builds use OpenGL ES 2, which Mesa's llvmpipe provides
+// without a display
+#include <GLES2/gl2.h>
+
+#define GL_TYPE_STRING "GLES"
+
+#define BUFFER_OFFSET(i) ((char*)nullptr + (i))
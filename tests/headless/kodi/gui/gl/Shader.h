@@ -0,0 +1,50 @@
+/*
+ *  Copyright (C) 2016-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "GL.h"
+
+#include <string>
+
+namespace kodi
+{
+namespace gui
+{
+namespace gl
+{
+
+class CShaderProgram
+{
+public:
+  CShaderProgram() = default;
+  virtual ~CShaderProgram();
+
+  bool LoadShaderFiles(const std::string& vert, const std::string& frag);
+  bool CompileAndLink(const std::string& vertexExtraBegin = "",
+                      const std::string& vertexExtraEnd = "",
+                      const std::string& fragmentExtraBegin = "",
+                      const std::string& fragmentExtraEnd = "");
+  bool EnableShader();
+  void DisableShader();
+  bool ShaderOK() const { return m_ok; }
+  GLuint ProgramHandle() const { return m_shaderProgram; }
+
+  virtual void OnCompiledAndLinked() {}
+  virtual bool OnEnabled() { return false; }
+  virtual void OnDisabled() {}
+
+private:
+  std::string m_vertexSource;
+  std::string m_fragmentSource;
+  GLuint m_shaderProgram = 0;
+  bool m_ok = false;
+};
+
+} /* namespace gl */
+} /* namespace gui */
+} /* namespace kodi */